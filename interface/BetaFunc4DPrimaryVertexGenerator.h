@@ -0,0 +1,55 @@
+#ifndef FastSimulation_Event_BetaFunc4DPrimaryVertexGenerator_H
+#define FastSimulation_Event_BetaFunc4DPrimaryVertexGenerator_H
+
+// Famos Headers
+#include "FastSimulation/Event/interface/BetaFuncPrimaryVertexGenerator.h"
+
+/** A class that generates a primary vertex in space and time, in cm and
+ *  cm/c, from the overlap of two Gaussian bunches of length BunchLength
+ *  colliding with the crossing angle (Alpha, Phi) of the BetaFunc 
+ *  parameters, with the same beta* and emittance (hourglass effect). 
+ *  The length of the luminous region follows from the bunch length and 
+ *  the crossing angle (SigmaZ is not used), and the time of the vertex 
+ *  is correlated to its position along the crossing plane. Without 
+ *  BunchLength, the bunches are sqrt(2) times longer than SigmaZ.
+ */
+
+class BetaFunc4DPrimaryVertexGenerator : public BetaFuncPrimaryVertexGenerator {
+
+public:
+  /// Default constructor
+  BetaFunc4DPrimaryVertexGenerator(const edm::ParameterSet& vtx,
+				   const RandomEngine* engine);
+
+  /// Destructor
+  ~BetaFunc4DPrimaryVertexGenerator() {;}
+  
+  /// Generation process (to be implemented)
+  virtual void generate();
+
+  /// Generation of n vertices at once
+  virtual void generateBatch(unsigned n, Batch& out);
+
+  /// The n vertices of the bunch crossing of this index (0 for the 
+  /// in-time crossing), their times shifted by the bunch spacing
+  void generateCrossing(int bunchCrossing, unsigned n, Batch& out);
+
+  /// The widths of the luminous region in z and in c.t, in cm
+  inline double sigmaZ() const { return sigmaZ_; }
+  inline double sigmaT() const { return sigmaT_; }
+
+ private:
+
+  double bunchLength_;
+  double bunchSpacing_;   // in cm/c
+
+  // Set once for all the crossings
+  double cosAlpha_, sinAlpha_;
+  double cosPhi_, sinPhi_;
+  double sigmaZ_, sigmaT_;
+
+  Batch vertex_;
+
+};
+
+#endif // BetaFunc4DPrimaryVertexGenerator_H
@@ -26,15 +26,16 @@ public:
   /// Generation process (to be implemented)
   virtual void generate();
 
+  /// Generation of n vertices at once
+  virtual void generateBatch(unsigned n, Batch& out);
+
   /// set resolution in Z in cm
   /// set mean in X in cm
   /// beta function
   double BetaFunction(double z, double z0);
   
-private:
+protected:
 
-  TMatrixD* inverseLorentzBoost();
-  
   double fX0, fY0, fZ0;
   double fSigmaZ;
   double alpha_, phi_;
@@ -0,0 +1,49 @@
+#ifndef FastSimulation_Event_CounterBasedRandom_H
+#define FastSimulation_Event_CounterBasedRandom_H
+
+#include <stdint.h>
+
+/** A counter-based random number generator (Philox4x32-10, Salmon et al.,
+ *  SC'11), used for the smearing of the primary vertices. The random
+ *  numbers are a function of a key (a seed, the run, the luminosity block
+ *  and the event number), of a stream (e.g., the index of the interaction
+ *  in the event) and of a block index in the stream, and of nothing else:
+ *  they are the same whatever the order in which they are drawn, or the
+ *  thread that draws them. 
+ */
+
+class CounterBasedRandom {
+
+ public:
+
+  /// Constructor from a seed
+  CounterBasedRandom(unsigned seed);
+
+  /// The event the random numbers are drawn for
+  void setEvent(unsigned run, unsigned lumi, unsigned long long event);
+
+  /// Four 32-bit random words: a block of a stream (stream < 2^30, block < 4)
+  void block(unsigned stream, unsigned block, uint32_t words[4]) const;
+
+  /// Two random numbers, flat in ]0,1], from a block of a stream
+  inline void flats(unsigned stream, unsigned block, double& u0, double& u1) const { 
+    uint32_t w[4];
+    this->block(stream,block,w);
+    u0 = flat(w[0],w[1]);
+    u1 = flat(w[2],w[3]);
+  }
+
+ private:
+
+  /// 53 random bits, as a number in ]0,1]
+  static inline double flat(uint32_t hi, uint32_t lo) { 
+    uint64_t bits = ((uint64_t)hi<<21) ^ (lo>>11);
+    return (bits+1) * (1./9007199254740992.);
+  }
+
+  uint32_t key_[2];
+  uint32_t event_[3];
+
+};
+
+#endif // CounterBasedRandom_H
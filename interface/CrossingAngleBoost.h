@@ -0,0 +1,44 @@
+#ifndef FastSimulation_Event_CrossingAngleBoost_H
+#define FastSimulation_Event_CrossingAngleBoost_H
+
+/** A 4x4 transformation of the four-vectors (x, y, z, t) or (px, py, pz, E),
+ *  kept by value: the boost between the laboratory and the frame where 
+ *  the beams collide head-on, for a crossing angle. It replaces the ROOT 
+ *  TMatrixD allocated and inverted numerically by the vertex generators, 
+ *  and is applied to arrays of four-vectors in a loop the compiler can 
+ *  vectorize.
+ */
+
+class CrossingAngleBoost {
+
+ public:
+
+  /// The identity
+  CrossingAngleBoost();
+
+  /// The boost to the head-on frame, for a half crossing angle phi in the
+  /// plane ZS, where S is at an angle alpha to the X axis in the XY plane
+  CrossingAngleBoost(double alpha, double phi);
+
+  /// The inverse transformation (cofactors, no pivoting)
+  CrossingAngleBoost inverse() const;
+
+  /// The element (i,j)
+  inline double operator()(unsigned i, unsigned j) const { return m_[i][j]; }
+
+  /// Transform one four-vector
+  inline void apply(const double in[4], double out[4]) const { 
+    for ( unsigned i=0; i<4; ++i ) 
+      out[i] = m_[i][0]*in[0] + m_[i][1]*in[1] + m_[i][2]*in[2] + m_[i][3]*in[3];
+  }
+
+  /// Transform n four-vectors in place, given as four arrays
+  void apply(unsigned n, double* x, double* y, double* z, double* t) const;
+
+ private:
+
+  double m_[4][4];
+
+};
+
+#endif // CrossingAngleBoost_H
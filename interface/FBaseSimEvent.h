@@ -12,10 +12,43 @@
 #include "FastSimulation/Particle/interface/RawParticle.h"
 #include "FastSimDataFormats/NuclearInteractions/interface/FSimVertexType.h"
 #include "FastSimDataFormats/NuclearInteractions/interface/FSimVertexTypeFwd.h"
-
+#include "FastSimulation/Event/interface/FSimTrackColumns.h"
+#include "FastSimulation/Event/interface/FSimSurfaceTable.h"
+#include "FastSimulation/Event/interface/FSimDaughterTable.h"
+#include "FastSimulation/Event/interface/FSimEventCapacityPolicy.h"
+#include "FastSimulation/Event/interface/FSimBatchPropagator.h"
+#include "FastSimulation/Event/interface/FSimPropagationPlan.h"
+#include "FastSimulation/Event/interface/FSimGenRecord.h"
+#include "FastSimulation/Event/interface/FSimTrackIdTable.h"
+#include "FastSimulation/Event/interface/FSimParticleProperties.h"
+
+// TBB
+#include "tbb/enumerable_thread_specific.h"
+
+#include <memory>
 #include <vector>
 
 /** FSimEvent special features for FAMOS
+ *
+ * The interface is split in two:
+ *  - the builder interface (non-const methods: fill, addParticles, 
+ *    addSimTrack, addSimVertex, and the non-const track, vertex and 
+ *    vertexType accessors) is used to fill the event, from one thread 
+ *    at a time;
+ *  - the reader interface (const methods) gives read-only access to the
+ *    content of the event. 
+ *
+ * Once filled, an event may be read concurrently from several threads 
+ * through its reader interface: the const methods do not modify the 
+ * event, and no mutable static object is used. Out-of-range indices 
+ * return invalid objects owned by each event. Several FBaseSimEvent's 
+ * (e.g., one per stream) may be filled concurrently.
+ *
+ * In the lazy propagation mode (see setLazyPropagation), the tracks are
+ * propagated to the calorimeters only when needed: by materialize(), or
+ * by the first call to a calorimeter accessor of the FSimTrack. These
+ * accessors then modify the event, and must not be called concurrently
+ * on the same event, unless materialize() was called first.
  *
  * \author Patrick Janot, CERN
  * \date: 9-Dec-2003
@@ -28,6 +61,7 @@ class KineParticleFilter;
 
 class SimTrack;
 class SimVertex;
+class BaseParticlePropagator;
 class PrimaryVertexGenerator;
 class RandomEngine;
 //class Histos;
@@ -45,9 +79,16 @@ namespace HepMC {
 class FBaseSimEvent  
 {
 
+  /// The FSimTrack's read and update their kinematics in the track columns, 
+  /// and their calorimeter entrance states in the surface table. The 
+  /// FSimTrack's and FSimVertex's read their daughters in the daughter tables.
+  friend class FSimTrack;
+  friend class FSimVertex;
+
 public:
 
-  /// Default constructor
+  /// Default constructor. Besides the particle filter cuts, kine may 
+  /// hold the optional settings of the event (see initializeOptions)
   FBaseSimEvent(const edm::ParameterSet& kine);
 
   FBaseSimEvent(const edm::ParameterSet& vtx,
@@ -57,14 +98,26 @@ public:
   ///  usual virtual destructor
   ~FBaseSimEvent();
 
-  /// Initialize the particle data table
+  /// Initialize the particle data table, and make the properties of its
+  /// particles for this event only
   void initializePdt(const HepPDT::ParticleDataTable* aPdt);
 
+  /// Initialize the particle data table, with the properties of its 
+  /// particles shared by all the events of the owner (they must have been
+  /// made from this table: a cms::Exception is thrown otherwise)
+  void initializePdt(const HepPDT::ParticleDataTable* aPdt,
+		     const std::shared_ptr<const FSimParticleProperties>& properties);
+
   /// Get the pointer to the particle data table
   inline const HepPDT::ParticleDataTable* theTable() const { 
     return pdt;
   }
 
+  /// The properties of the particles of the table (see initializePdt)
+  inline const FSimParticleProperties* particleProperties() const { 
+    return theParticleProperties.get();
+  }
+
   /// fill the FBaseSimEvent from the current HepMC::GenEvent
   void fill(const HepMC::GenEvent& hev);
 
@@ -84,9 +137,74 @@ public:
   /// print the FBaseSimEvent in an intelligible way
   void print() const;
 
-  /// clear the FBaseSimEvent content before the next event
+  /// clear the FBaseSimEvent content before the next event.
+  /// The memory is kept: once the buffers have grown to the size of 
+  /// the largest event, filling an event does not allocate any memory.
   void clear();
 
+  /// The number of times one of the event buffers (tracks, vertices, 
+  /// daughters, surface states...) had to grow or was released since 
+  /// construction. This is not a count of heap allocations: the growth
+  /// of a buffer may take several, and other objects allocate too.
+  unsigned long nAllocations() const;
+
+  /// Set the policy used to size the event buffers (applied to both the 
+  /// track and the vertex buffers, which learn their sizes separately).
+  /// The buffers are released and preallocated to the new initial size.
+  void setCapacityPolicy(const FSimEventCapacityPolicy& policy);
+
+  /// The memory currently taken by the event buffers, in bytes
+  unsigned long memoryFootprint() const;
+
+  /// When filled from SimTrack's and SimVertex'ices, the tracks are 
+  /// propagated to the calorimeters in blocks of tracksPerBlock tracks,
+  /// in parallel (with TBB) if requested. The default is serial: the
+  /// blocks are run one after the other in the calling thread, which 
+  /// is what a framework already running one event per thread wants.
+  /// The result does not depend on the number of threads.
+  void setParallelPropagation(bool parallel, unsigned tracksPerBlock=64);
+
+  /// Propagate the tracks to the calorimeters with the analytical batch 
+  /// propagator (FSimBatchPropagator) instead of BaseParticlePropagator 
+  /// (the default), block by block.
+  void setBatchPropagation(bool batch);
+
+  /// When filled from SimTrack's and SimVertex'ices, do not propagate 
+  /// the tracks to the calorimeters: each track is propagated up to a 
+  /// surface at the first call to its accessors for that surface (e.g., 
+  /// FSimTrack::ecalEntrance() or FSimTrack::onEcal()), and the result
+  /// is kept. Events of which only the kinematics is read skip the 
+  /// propagation entirely. As these accessors then modify the event, 
+  /// they are not thread safe: call materialize() first to read the 
+  /// event from several threads.
+  void setLazyPropagation(bool lazy);
+
+  /// Set the surfaces, particles and magnetic field used to propagate the 
+  /// tracks to the calorimeters (by default, all surfaces for all 
+  /// particles in a 4 T field)
+  void setPropagationPlan(const FSimPropagationPlan& plan);
+
+  /// Propagate all the tracks up to calorimeter surface s, each from the
+  /// last surface it reached (lazy propagation only; no-op otherwise). 
+  /// The surfaces beyond the HCAL entrance depend on the state found 
+  /// there, and are computed together. The tracks are propagated by
+  /// blocks, in parallel if requested, with BaseParticlePropagator.
+  void materialize(FSimSurfaceTable::Surface s);
+
+  /// The same, for track id only
+  void materialize(int id, FSimSurfaceTable::Surface s);
+
+  /// Is track id still to be propagated up to surface s ? (lazy 
+  /// propagation only; always false otherwise)
+  inline bool notYetPropagated(int id, FSimSurfaceTable::Surface s) const { 
+    return (unsigned)id < theLazyLevel.size() && 
+      theLazyLevel[id] < ( s > FSimSurfaceTable::HCAL ? FSimSurfaceTable::HO : s );
+  }
+
+  /// Propagate all the tracks to all the calorimeter surfaces they have
+  /// not reached yet (lazy propagation only; no-op otherwise)
+  void materializeAll();
+
 
   /// Add an id in the vector of charged tracks id's
   void addChargedTrack(int id);
@@ -111,14 +229,29 @@ public:
     return nChargedParticleTracks;
   }
 
-  /// Return track with given Id 
-  inline FSimTrack& track(int id) const;
+  /// Return track with given Id (an invalid track if out of range)
+  inline const FSimTrack& track(int id) const;
+
+  /// Return track with given Id, to be updated while filling the event
+  inline FSimTrack& track(int id);
+
+  /// The columnar store of the track kinematics, types and vertex indices
+  /// (valid for indices 0 to nTracks()-1), for loops over all tracks
+  inline const FSimTrackColumns& trackColumns() const { 
+    return *theTrackColumns;
+  }
+
+  /// Return vertex with given Id (an invalid vertex if out of range)
+  inline const FSimVertex& vertex(int id) const;
 
-  /// Return vertex with given Id 
-  inline FSimVertex& vertex(int id) const;
+  /// Return vertex with given Id, to be updated while filling the event
+  inline FSimVertex& vertex(int id);
 
-  /// Return vertex with given Id 
-  inline FSimVertexType& vertexType(int id) const;
+  /// Return vertex type with given Id (an invalid type if out of range)
+  inline const FSimVertexType& vertexType(int id) const;
+
+  /// Return vertex type with given Id, to be updated while filling the event
+  inline FSimVertexType& vertexType(int id);
 
   /// return "reconstructed" charged tracks index.
   int chargedTrack(int id) const;
@@ -145,7 +278,13 @@ public:
 
   const KineParticleFilter& filter() const { return *myFilter; } 
 
-  PrimaryVertexGenerator* thePrimaryVertexGenerator() const { return theVertexGenerator; }
+  /// To be called at the end of the job by the owner of the event 
+  /// (reports the particle filter counts, if requested)
+  void endJob() const;
+
+  const PrimaryVertexGenerator* thePrimaryVertexGenerator() const { return theVertexGenerator; }
+
+  PrimaryVertexGenerator* thePrimaryVertexGenerator() { return theVertexGenerator; }
 
   /// Set the beam spot position
   inline void setBeamSpot(const math::XYZPoint& aBeamSpot) { 
@@ -155,39 +294,82 @@ public:
  protected:
 
   /// The pointer to the vector of FSimTrack's 
-  inline std::vector<FSimTrack>* tracks() const { 
+  inline const std::vector<FSimTrack>* tracks() const { 
+    return theSimTracks; 
+  }
+
+  inline std::vector<FSimTrack>* tracks() { 
     return theSimTracks; 
   }
 
   /// The pointer to the vector of FSimVertex's 
-  inline std::vector<FSimVertex>* vertices() const { 
+  inline const std::vector<FSimVertex>* vertices() const { 
+    return theSimVertices; 
+  }
+
+  inline std::vector<FSimVertex>* vertices() { 
     return theSimVertices; 
   }
 
   /// The pointer to the vector of GenParticle's 
-  inline std::vector<HepMC::GenParticle*>* genparts() const { 
+  inline const std::vector<HepMC::GenParticle*>* genparts() const { 
+    return theGenParticles; 
+  }
+
+  inline std::vector<HepMC::GenParticle*>* genparts() { 
     return theGenParticles; 
   }
 
  private:
 
   std::vector<FSimTrack>* theSimTracks;
+  FSimTrackColumns* theTrackColumns;
+  FSimSurfaceTable* theSurfaceTable;
+  FSimGenRecord* theGenRecord;
+  FSimTrackIdTable* theTrackIdTable;
+  FSimDaughterTable* theVertexDaughters;
+  FSimDaughterTable* theTrackDaughters;
   std::vector<FSimVertex>* theSimVertices;
   FSimVertexTypeCollection* theFSimVerticesType;
   std::vector<HepMC::GenParticle*>* theGenParticles;
 
   std::vector<unsigned>* theChargedTracks;
 
+  /// The objects returned for out-of-range indices
+  FSimTrack* theInvalidTrack;
+  FSimVertex* theInvalidVertex;
+  FSimVertexType* theInvalidVertexType;
+
   unsigned int nSimTracks;
   unsigned int nSimVertices;
   unsigned int nGenParticles;
   unsigned int nChargedParticleTracks;
 
-  unsigned int theTrackSize;
-  unsigned int theVertexSize;
-  unsigned int theGenSize;
-  unsigned int theChargedSize;
-  unsigned int initialSize;
+  /// The sizing of the track and vertex buffers
+  FSimEventCapacityPolicy theTrackCapacity;
+  FSimEventCapacityPolicy theVertexCapacity;
+
+  /// The number of times the vectors above had to grow
+  unsigned long nBufferAllocations;
+
+  /// Working arrays, kept from one event to the next
+  std::vector<int> theSimVertexIndex;  // SimVertex index -> FSimVertex index
+  std::vector<int> theSimVertexMother; // SimVertex index -> mother SimTrack index
+  std::vector<int> theSimTrackIndex;   // SimTrack index -> FSimTrack index
+  std::vector<int> theGenVertexIndex;  // GenParticle barcode -> FSimVertex index
+
+  /// The propagation to the calorimeters, by blocks of tracks
+  bool theParallelPropagation;
+  unsigned theTracksPerBlock;
+  std::vector< std::vector<FSimSurfaceTable::Hit> > theSurfaceHits; // The states found, per block
+  std::vector<unsigned> theSurfaceHitRoom;  // The room in each block before the propagation
+  bool theBatchPropagation;
+  tbb::enumerable_thread_specific<FSimBatchPropagator>* theBatchPropagators;
+  bool theLazyPropagation;
+  FSimPropagationPlan thePropagationPlan;
+  std::vector<int> theLazyLevel;  // The last surface reached by each track (lazy propagation)
+  std::vector<RawParticle> theLazyStates;  // The state of each track on that surface
+  std::vector<FSimSurfaceTable::Hit> theLazyHits;  // The states found for one track
 
   /// The particle filter
   KineParticleFilter* myFilter;
@@ -197,6 +379,7 @@ public:
   double sigmaVerteZ;
 
   const ParticleDataTable * pdt;
+  std::shared_ptr<const FSimParticleProperties> theParticleProperties;
 
   PrimaryVertexGenerator* theVertexGenerator;
   math::XYZPoint theBeamSpot;
@@ -206,6 +389,62 @@ public:
 
   //  Histos* myHistos;
 
+  /// Read the optional settings of the event from the particle filter 
+  /// parameters: CapacityPolicy (an untracked PSet, see 
+  /// FSimEventCapacityPolicy), parallelPropagation and tracksPerBlock
+  /// (untracked, see setParallelPropagation), batchPropagation and
+  /// lazyPropagation (untracked, see setBatchPropagation and 
+  /// setLazyPropagation), and PropagationPlan (a PSet, see 
+  /// FSimPropagationPlan)
+  void initializeOptions(const edm::ParameterSet& kine);
+
+  /// Create the vectors of particles and vertices
+  void initializeBuffers();
+
+  /// Learn the size of the event just processed, and preallocate or 
+  /// release the buffers accordingly
+  void adaptCapacity();
+
+  /// Release all the memory, and preallocate nTracks tracks and nVertices vertices
+  void releaseBuffers(unsigned nTracks, unsigned nVertices);
+
+  /// Assign n copies of value to a working array, counting its reallocations
+  void assign(std::vector<int>& array, unsigned n, int value);
+
+  /// Propagate all tracks to the calorimeters, up to surface last, and 
+  /// store the states found
+  void propagateToCalorimeters(FSimSurfaceTable::Surface last=FSimSurfaceTable::HO);
+
+  /// Propagate the tracks of a given block (may run concurrently with
+  /// other blocks: only theSurfaceHits[block], and the lazy propagation
+  /// status of the tracks of the block, are modified)
+  void propagateBlock(unsigned block, FSimSurfaceTable::Surface last);
+
+  /// Propagate one track to the calorimeters with the propagator myPart, 
+  /// from surface first to surface last (in the order of the enum), and 
+  /// keep the states found in hits. Unless first is LAYER1, myPart must
+  /// hold the state reached before first.
+  void propagateTrack(int fsimi, BaseParticlePropagator& myPart,
+		      std::vector<FSimSurfaceTable::Hit>& hits,
+		      FSimSurfaceTable::Surface first=FSimSurfaceTable::LAYER1,
+		      FSimSurfaceTable::Surface last=FSimSurfaceTable::HO) const;
+
+  /// Propagate track id up to surface s from the last surface it reached,
+  /// if not yet done, and keep the states found in hits (lazy propagation;
+  /// may run concurrently for different tracks)
+  void propagateLazily(int id, FSimSurfaceTable::Surface s,
+		       std::vector<FSimSurfaceTable::Hit>& hits);
+
+  /// Propagate the tracks first to last-1 to the calorimeters with the 
+  /// batch propagator, and keep the states found in hits
+  void propagateBatch(int first, int last, FSimBatchPropagator& batch,
+		      std::vector<FSimSurfaceTable::Hit>& hits) const;
+
+  /// The position and momentum of a track at the tracker surface
+  void trackerSurfaceState(const FSimTrack& myTrack,
+			   XYZTLorentzVector& pos,
+			   XYZTLorentzVector& mom) const;
+
 };
 
 #include "FastSimulation/Event/interface/FBaseSimEvent.icc"
@@ -0,0 +1,128 @@
+#ifndef FastSimulation_Event_FSimBatchPropagator_H
+#define FastSimulation_Event_FSimBatchPropagator_H
+
+// Data Formats
+#include "DataFormats/Math/interface/LorentzVector.h"
+
+// Famos Headers
+#include "FastSimulation/Event/interface/FSimSurfaceTable.h"
+#include "FastSimulation/Event/interface/FSimSurfaceGeometry.h"
+
+#include <vector>
+
+class RawParticle;
+
+/** A batch propagator of particles from the tracker surface to the
+ *  calorimeter surfaces (preshower layers, ECAL, HCAL, VFCAL, HCAL exit
+ *  and HO), in a constant solenoidal magnetic field.
+ *
+ *  The particles are stored in arrays (one per coordinate), and each
+ *  surface is computed for all particles at once, with loops free of
+ *  branches and of function calls other than the math library, that
+ *  the compiler can vectorize. The intersections are computed
+ *  analytically, from the tracker surface, with the surfaces and
+ *  acceptances of BaseParticlePropagator (see FSimSurfaceGeometry):
+ *   - LAYER1, LAYER2 : preshower disks (45 < r < 125 cm), success = 2;
+ *   - ECAL  : barrel (success = 1) or, beyond |eta|=1.479, endcap
+ *             (success = 2), up to |eta|=3;
+ *   - HCAL  : barrel (1) or endcap (2), up to |eta|=3;
+ *   - VFCAL : the HF front face (2), between |eta|=3 and 5;
+ *   - HCALEXIT : outer HCAL cylinder (1 or 2), up to |eta|=3;
+ *   - HO    : from the HCAL exit, in no magnetic field (1), up to |eta|=1.26.
+ *  As in FBaseSimEvent, the VFCAL is computed for particles with
+ *  cos^2(theta) > 0.8 at HCAL entrance or with E < 3 GeV, the HCAL exit
+ *  and HO for the others.
+ */
+
+class FSimBatchPropagator {
+
+ public:
+
+  /// Constructor, with the magnetic field (in T)
+  FSimBatchPropagator(double bField=4.);
+
+  /// Forget all the particles (the memory is kept)
+  void clear();
+
+  /// Add a particle (position and momentum at the tracker surface, charge)
+  void add(const math::XYZTLorentzVector& pos,
+	   const math::XYZTLorentzVector& mom,
+	   float charge);
+
+  /// The number of particles
+  inline unsigned size() const { return x_.size(); }
+
+  /// Propagate all particles to the surfaces of the mask steps (see 
+  /// FSimPropagationPlan::bit and FSimPropagationPlan::steps, which adds 
+  /// the surfaces needed to reach the others), all by default. The
+  /// particles are not in the acceptance of the other surfaces.
+  void propagate(unsigned steps=~0U);
+
+  /// Was particle i propagated to surface s ?
+  inline bool computed(unsigned i, FSimSurfaceTable::Surface s) const {
+    return vfcal_[i] ?
+      s != FSimSurfaceTable::HCALEXIT && s != FSimSurfaceTable::HO :
+      s != FSimSurfaceTable::VFCAL;
+  }
+
+  /// The success of the propagation of particle i to surface s
+  /// (0: not in the surface acceptance, 1: barrel, 2: endcap)
+  inline int success(unsigned i, FSimSurfaceTable::Surface s) const {
+    return out_[s].success[i];
+  }
+
+  /// The particle i on surface s
+  RawParticle state(unsigned i, FSimSurfaceTable::Surface s) const;
+
+  /// The memory taken by the arrays, in bytes
+  unsigned long memory() const;
+
+ private:
+
+  /// The particles at the tracker surface
+  std::vector<double> x_, y_, z_, t_, px_, py_, pz_, e_, q_;
+
+  /// Quantities derived once per particle
+  std::vector<double> pt_;   // Transverse momentum
+  std::vector<double> rho_;  // Signed helix radius (0 for neutrals)
+  std::vector<double> xc_;   // Helix centre
+  std::vector<double> yc_;
+  std::vector<double> phi_;  // Initial azimuthal angle of the momentum
+  std::vector<int> vfcal_;   // 1 if the VFCAL is computed rather than HO
+
+  /// The particles on a surface
+  struct Surface {
+    std::vector<double> x, y, z, t, px, py, pz;
+    std::vector<int> success;
+    void resize(unsigned n);
+    unsigned long memory() const;
+  };
+  Surface out_[FSimSurfaceTable::NSURFACES];
+
+  /// Working arrays
+  std::vector<double> path_;   // Transverse path length
+  std::vector<int> side_;      // 1: barrel, 2: endcap, 0: not reached
+  Surface work_;
+
+  double bField_;
+
+  /// Compute the transverse path length to the cylinder c, closed by 
+  /// two disks, for all particles
+  void cylinder(const FSimSurfaceGeometry::Cylinder& c);
+
+  /// Move all particles along their helix by the path lengths found
+  void move(Surface& s) const;
+
+  /// Move all particles along a straight line from surface s,
+  /// to the cylinder c
+  void straight(const Surface& from, const FSimSurfaceGeometry::Cylinder& c, Surface& to);
+
+  /// Keep in s the particles found in work_ for which select is true
+  void select(Surface& s, const std::vector<int>& select) const;
+
+  /// Put all particles out of the acceptance of surface s
+  void skip(Surface& s) const;
+
+};
+
+#endif // FSimBatchPropagator_H
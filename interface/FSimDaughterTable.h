@@ -0,0 +1,90 @@
+#ifndef FastSimulation_Event_FSimDaughterTable_H
+#define FastSimulation_Event_FSimDaughterTable_H
+
+#include <vector>
+
+/** The daughter indices of all the parents (vertices or tracks) of an
+ *  FBaseSimEvent, in a single flat array: each parent owns a contiguous
+ *  range of this array, given by an offset and a size (compressed sparse
+ *  row adjacency). Daughters can be added at any time, in any parent
+ *  order: a parent whose range is full is moved to the end of the array
+ *  with twice the room. finalize() compacts the array so that the
+ *  daughters of consecutive parents are consecutive in memory.
+ *
+ *  The memory is kept from one event to the next.
+ */
+
+class FSimDaughterTable {
+
+ public:
+
+  /// A view on the daughter indices of one parent. It is valid until
+  /// the next daughter is added to the table.
+  class Range {
+  public:
+    typedef const int* const_iterator;
+    Range() : begin_(0), end_(0) {}
+    Range(const int* b, const int* e) : begin_(b), end_(e) {}
+    inline const_iterator begin() const { return begin_; }
+    inline const_iterator end() const { return end_; }
+    inline unsigned size() const { return end_-begin_; }
+    inline bool empty() const { return begin_ == end_; }
+    inline int operator[](unsigned i) const { return begin_[i]; }
+    inline int back() const { return *(end_-1); }
+  private:
+    const int* begin_;
+    const int* end_;
+  };
+
+  /// Default constructor
+  FSimDaughterTable();
+
+  /// Forget all the daughters (the memory is kept for the next event)
+  void clear();
+
+  /// Forget all the daughters and release the memory
+  void release();
+
+  /// The memory taken by the table, in bytes
+  unsigned long memory() const;
+
+  /// Add a daughter to the list of the parent
+  void add(int parent, int daughter);
+
+  /// Compact the daughter array in parent order
+  void finalize();
+
+  /// The number of daughters of the parent
+  inline int nDaughters(int parent) const {
+    return parent >= 0 && parent < (int)size_.size() ? size_[parent] : 0;
+  }
+
+  /// The ith daughter of the parent
+  inline int daughter(int parent, int i) const {
+    return children_[first_[parent]+i];
+  }
+
+  /// The daughters of the parent
+  inline Range daughters(int parent) const {
+    int n = nDaughters(parent);
+    if ( !n ) return Range();
+    const int* first = &children_[first_[parent]];
+    return Range(first,first+n);
+  }
+
+  /// The number of times the table had to grow
+  inline unsigned long nAllocations() const { return nAllocations_; }
+
+ private:
+
+  std::vector<int> first_;     // The offset of the first daughter, per parent
+  std::vector<int> size_;      // The number of daughters, per parent
+  std::vector<int> room_;      // The number of slots reserved, per parent
+  std::vector<int> children_;  // The daughter indices
+  std::vector<int> buffer_;    // Working array for finalize()
+
+  unsigned long nAllocations_;
+
+};
+
+#endif // FSimDaughterTable_H
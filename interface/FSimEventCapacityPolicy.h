@@ -0,0 +1,74 @@
+#ifndef FastSimulation_Event_FSimEventCapacityPolicy_H
+#define FastSimulation_Event_FSimEventCapacityPolicy_H
+
+#include <vector>
+
+namespace edm {
+  class ParameterSet;
+}
+
+/** The policy used by FBaseSimEvent to size its buffers. It learns the
+ *  number of tracks (or vertices) of the recent events, and tells
+ *   - how much room to preallocate: a given percentile of the recent
+ *     event sizes, with some headroom;
+ *   - when to release the memory taken by an outlier event: once the
+ *     buffers are much larger than needed, and a given number of
+ *     consecutive normal events have been seen.
+ *
+ *  The parameters (all untracked, with defaults) are:
+ *   - initialSize   : the room preallocated before any event is seen (5000)
+ *   - window        : the number of recent events remembered (100)
+ *   - percentile    : the fraction of recent events that must fit (0.95)
+ *   - headroom      : the factor applied to the percentile (1.2)
+ *   - outlierFactor : buffers larger than outlierFactor times the
+ *                     preallocation are candidates for release (2.)
+ *   - releaseAfter  : the number of normal events to wait for (50)
+ *
+ *  FBaseSimEvent reads them from the CapacityPolicy PSet of the particle
+ *  filter parameters (ParticleFilter_cfi.py), if present.
+ */
+
+class FSimEventCapacityPolicy {
+
+ public:
+
+  /// Default constructor, with the default parameters
+  FSimEventCapacityPolicy();
+
+  /// Constructor from a parameter set
+  FSimEventCapacityPolicy(const edm::ParameterSet& buffers);
+
+  /// Record the size of the event just processed
+  void record(unsigned size);
+
+  /// The room to preallocate for the next event
+  unsigned target() const;
+
+  /// Should a buffer with this capacity be released down to target() ?
+  bool release(unsigned capacity) const;
+
+  /// The room preallocated before any event is seen
+  inline unsigned initialSize() const { return theInitialSize; }
+
+ private:
+
+  unsigned theInitialSize;
+  unsigned theWindow;
+  double thePercentile;
+  double theHeadroom;
+  double theOutlierFactor;
+  unsigned theReleaseAfter;
+
+  std::vector<unsigned> theSizes;  // The sizes of the recent events (circular)
+  unsigned theNext;                // The next entry to be filled in theSizes
+  unsigned theTarget;              // The current preallocation
+  unsigned nNormalEvents;          // The number of consecutive events that fit
+
+  std::vector<unsigned> theWork;   // Working array for the percentile
+
+  /// Compute the preallocation from the recent event sizes
+  void update();
+
+};
+
+#endif // FSimEventCapacityPolicy_H
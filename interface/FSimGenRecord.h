@@ -0,0 +1,144 @@
+#ifndef FastSimulation_Event_FSimGenRecord_H
+#define FastSimulation_Event_FSimGenRecord_H
+
+// Data Formats
+#include "DataFormats/Math/interface/LorentzVector.h"
+
+#include <vector>
+
+namespace HepMC {
+  class GenEvent;
+  class GenParticle;
+}
+
+/** A flat copy of the particles of a HepMC::GenEvent, made in one pass
+ *  over the event, and used by FBaseSimEvent to select the particles to
+ *  be simulated without walking the HepMC graph again. For each particle
+ *  (in the order of the GenEvent, i.e., of increasing barcode), the
+ *  record holds, in contiguous arrays:
+ *   - the PDG id, the status and the momentum;
+ *   - the production and end vertex positions, in cm (zero if no vertex);
+ *   - the index of the mother (the first incoming particle of the
+ *     production vertex, -1 if none);
+ *   - the range of the daughters (the outgoing particles of the end vertex).
+ *
+ *  It also classifies the particles to be simulated (classify): stable
+ *  particles, particles with stable daughters, and particles produced
+ *  away from the primary vertex are kept; the first ones, and the 
+ *  particles that decay beyond the beam pipe, are declared stable. The
+ *  classification is made for all particles at once, without branches, 
+ *  from the arrays; classifyReference() makes the same classification 
+ *  particle by particle, as historically done in FBaseSimEvent, and 
+ *  must give the same masks.
+ */
+
+class FSimGenRecord {
+
+ public:
+
+  /// Default constructor
+  FSimGenRecord();
+
+  /// Flatten a GenEvent
+  void fill(const HepMC::GenEvent& myGenEvent);
+
+  /// Forget the particles (the memory is kept for the next event)
+  void clear();
+
+  /// Release the memory
+  void release();
+
+  /// The memory taken by the record, in bytes
+  unsigned long memory() const;
+
+  /// The number of times the record had to grow
+  inline unsigned long nAllocations() const { return nAllocations_; }
+
+  /// The number of particles
+  inline unsigned size() const { return pdgId_.size(); }
+
+  /// The original particle
+  inline HepMC::GenParticle* particle(int i) const { return particle_[i]; }
+
+  /// The PDG id, status and momentum of particle i
+  inline int pdgId(int i) const { return pdgId_[i]; }
+  inline int status(int i) const { return status_[i]; }
+  inline const math::XYZTLorentzVector& momentum(int i) const { return momentum_[i]; }
+
+  /// The production vertex of particle i (in cm)
+  inline bool hasProductionVertex(int i) const { return productionBarcode_[i] != 0; }
+  inline const math::XYZTLorentzVector& productionVertex(int i) const { return production_[i]; }
+
+  /// The end vertex of particle i (in cm)
+  inline bool hasEndVertex(int i) const { return endBarcode_[i] != 0; }
+  inline const math::XYZTLorentzVector& endVertex(int i) const { return end_[i]; }
+
+  /// The mother of particle i (-1 if none)
+  inline int mother(int i) const { return mother_[i]; }
+
+  /// The daughters of particle i
+  inline int nDaughters(int i) const { return nDaughters_[i]; }
+  inline int daughter(int i, int k) const { return daughters_[firstDaughter_[i]+k]; }
+
+  /// Classify the particles, with the primary vertex position, the 
+  /// smearing of the vertices, and the square of the transverse distance
+  /// beyond which a decay is considered late (all in cm)
+  void classify(const math::XYZTLorentzVector& primaryVertex,
+		const math::XYZTLorentzVector& smearing,
+		double lateVertexPosition);
+
+  /// The same, particle by particle (the reference implementation)
+  void classifyReference(const math::XYZTLorentzVector& primaryVertex,
+			 const math::XYZTLorentzVector& smearing,
+			 double lateVertexPosition);
+
+  /// Is particle i to be simulated (after classify) ?
+  inline bool kept(int i) const { return keep_[i]; }
+
+  /// Is particle i declared stable (after classify) ?
+  inline bool declaredStable(int i) const { return stable_[i]; }
+
+  /// The masks found by classify (1 for the particles kept / declared stable)
+  inline const int* keepMask() const { return keep_.data(); }
+  inline const int* stableMask() const { return stable_.data(); }
+
+  /// Direct access to the arrays, for loops over all particles
+  inline const int* pdgIds() const { return pdgId_.data(); }
+  inline const int* statuses() const { return status_.data(); }
+  inline const int* mothers() const { return mother_.data(); }
+  inline const int* nDaughters() const { return nDaughters_.data(); }
+  inline const math::XYZTLorentzVector* productionVertices() const { return production_.data(); }
+  inline const math::XYZTLorentzVector* endVertices() const { return end_.data(); }
+
+ private:
+
+  std::vector<HepMC::GenParticle*> particle_;
+  std::vector<int> barcode_;
+  std::vector<int> pdgId_;
+  std::vector<int> status_;
+  std::vector<math::XYZTLorentzVector> momentum_;
+  std::vector<int> productionBarcode_;   // 0 if none
+  std::vector<math::XYZTLorentzVector> production_;
+  std::vector<int> endBarcode_;          // 0 if none
+  std::vector<math::XYZTLorentzVector> end_;
+  std::vector<int> mother_;
+  std::vector<int> firstDaughter_;
+  std::vector<int> nDaughters_;
+  std::vector<int> daughters_;  // The particles ordered by production vertex
+
+  /// The classification
+  std::vector<int> stableCount_;  // Number of stable particles in daughters_, before each position
+  std::vector<int> keep_;
+  std::vector<int> stable_;
+
+  unsigned long nAllocations_;
+
+  /// Make room for n particles
+  void reserve(unsigned n);
+
+  /// The index of the particle with this barcode (-1 if none)
+  int index(int barcode) const;
+
+};
+
+#endif // FSimGenRecord_H
@@ -0,0 +1,76 @@
+#ifndef FastSimulation_Event_FSimParticleProperties_H
+#define FastSimulation_Event_FSimParticleProperties_H
+
+// HepPDT Headers
+#include "SimGeneral/HepPDTRecord/interface/ParticleDataTable.h"
+
+#include <vector>
+
+class KineParticleFilter;
+
+/** A flat copy of the properties of the particles of a ParticleDataTable
+ *  (charge, mass, c.tau, whether the species is simulated at all, and 
+ *  whether it is forbidden by the particle filter). It is immutable once
+ *  made: the owner of the events makes it once per table (e.g., at each
+ *  change of the HepPDT record) and hands it, through a shared pointer, 
+ *  to all its FBaseSimEvent's (see FBaseSimEvent::initializePdt), which 
+ *  may then be filled concurrently. It points to the table content, and
+ *  must not be used after the table is deleted.
+ *
+ *  Each species is designated by a compact index, found without any map
+ *  lookup for |PDG id| < 10000: the FSimTrack's keep this index instead
+ *  of a pointer to the HepPDT::ParticleData.
+ */
+
+class FSimParticleProperties {
+
+ public:
+
+  /// Copy the table, with the classification of the species by the 
+  /// particle filter (made from the same parameters as the events')
+  FSimParticleProperties(const HepPDT::ParticleDataTable& pdt,
+			 const KineParticleFilter& filter);
+
+  /// The table copied
+  inline const HepPDT::ParticleDataTable* table() const { return table_; }
+
+  /// The index of a species (-1 if not in the table)
+  inline int index(int pdgId) const {
+    return pdgId > -NDENSE && pdgId < NDENSE ?
+      dense_[pdgId+NDENSE] : sparseIndex(pdgId);
+  }
+
+  /// The properties of the species of index i (i>=0)
+  inline int pdgId(int i) const { return pdgId_[i]; }
+  inline float charge(int i) const { return charge_[i]; }
+  inline double mass(int i) const { return mass_[i]; }
+  inline double cTau(int i) const { return cTau_[i]; }
+  inline bool simulable(int i) const { return simulable_[i]; }
+  inline bool forbidden(int i) const { return forbidden_[i]; }
+  inline const HepPDT::ParticleData* particleData(int i) const { return data_[i]; }
+
+  /// The number of species
+  inline unsigned size() const { return pdgId_.size(); }
+
+ private:
+
+  /// The index of a species with |PDG id| >= NDENSE
+  int sparseIndex(int pdgId) const;
+
+  const HepPDT::ParticleDataTable* table_;
+
+  enum { NDENSE=10000 };
+  std::vector<int> dense_;                 // PDG id + NDENSE -> index
+  std::vector< std::pair<int,int> > sparse_;  // Sorted (PDG id, index), |PDG id| >= NDENSE
+
+  std::vector<int> pdgId_;
+  std::vector<float> charge_;
+  std::vector<double> mass_;
+  std::vector<double> cTau_;
+  std::vector<char> simulable_;
+  std::vector<char> forbidden_;
+  std::vector<const HepPDT::ParticleData*> data_;
+
+};
+
+#endif // FSimParticleProperties_H
@@ -0,0 +1,80 @@
+#ifndef FastSimulation_Event_FSimPropagationPlan_H
+#define FastSimulation_Event_FSimPropagationPlan_H
+
+// Famos Headers
+#include "FastSimulation/Event/interface/FSimSurfaceTable.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace edm {
+  class ParameterSet;
+}
+
+/** The plan followed by FBaseSimEvent to propagate the tracks filled
+ *  from SimTrack's to the calorimeter surfaces:
+ *   - bField : the magnetic field (T);
+ *   - skippedParticles : the particles (|PDG id|) never propagated;
+ *   - Layer1, Layer2, Ecal, Hcal, VFcal, HcalExit, HO : one PSet per
+ *     surface (a missing PSet means that the surface is not computed), with
+ *       propagate : compute the particle state on that surface;
+ *       pTMin, EMin : the minimal transverse momentum and energy (GeV)
+ *                     at the tracker surface;
+ *       particles : the only particles (|PDG id|) propagated to that
+ *                   surface (all if empty).
+ *
+ *  The plan is compiled, once, into a table of the surfaces allowed for
+ *  each species, so that the set of surfaces of a track is obtained with
+ *  one look-up and a few comparisons. The default plan computes all
+ *  surfaces for all particles, in a 4 T field.
+ */
+
+class FSimPropagationPlan {
+
+ public:
+
+  /// Default constructor : all surfaces for all particles
+  FSimPropagationPlan();
+
+  /// Constructor from a parameter set
+  FSimPropagationPlan(const edm::ParameterSet& plan);
+
+  /// The bit of a surface in the masks below
+  static inline unsigned bit(FSimSurfaceTable::Surface s) { return 1U << s; }
+
+  /// The surfaces on which the state of a particle with this PDG id and
+  /// this transverse momentum and energy (at the tracker surface) is kept
+  unsigned surfaces(int pdgId, double pt, double e) const;
+
+  /// The surfaces to which the particle must be propagated to obtain its
+  /// state on the given surfaces (the choice between VFCAL and HCAL exit
+  /// is made at HCAL entrance, and HO is reached from the HCAL exit)
+  static unsigned steps(unsigned surfaces);
+
+  /// The magnetic field (T)
+  inline double bField() const { return theBField; }
+
+  /// The name of a surface in the parameter set
+  static std::string name(FSimSurfaceTable::Surface s);
+
+ private:
+
+  double theBField;
+
+  /// The surfaces allowed for the species not listed below
+  unsigned theDefaultMask;
+
+  /// The surfaces allowed for the species listed in the plan, sorted by |PDG id|
+  std::vector< std::pair<int,unsigned> > theSpeciesMasks;
+
+  /// The kinematic thresholds, per surface
+  double thePtMin[FSimSurfaceTable::NSURFACES];
+  double theEMin[FSimSurfaceTable::NSURFACES];
+
+  /// The surfaces with a kinematic threshold
+  unsigned theThresholdMask;
+
+};
+
+#endif // FSimPropagationPlan_H
@@ -0,0 +1,58 @@
+#ifndef FastSimulation_Event_FSimSurfaceGeometry_H
+#define FastSimulation_Event_FSimSurfaceGeometry_H
+
+/** The calorimeter surfaces to which the tracks are propagated, as
+ *  hard-coded in the propagateToXXX methods of BaseParticlePropagator:
+ *  cylinders (radius and half length, in cm) closed by two disks, and
+ *  the boundaries of their acceptances. FSimBatchPropagator and
+ *  FBaseSimEvent take them from here; testEventConsistency checks that
+ *  they still agree with BaseParticlePropagator.
+ */
+
+namespace FSimSurfaceGeometry {
+
+  /// A cylinder closed by two disks
+  struct Cylinder {
+    double radius;
+    double halfLength;
+  };
+
+  /// Preshower layers : only the disks, between preshowerRMin and
+  /// preshowerRMax
+  const Cylinder layer1 = { 129.0, 303.353 };
+  const Cylinder layer2 = { 129.0, 307.838 };
+  const double preshowerRMin = 45.0;
+  const double preshowerRMax = 125.0;
+
+  /// ECAL entrance : the barrel up to |eta| = 1.479, the endcap beyond,
+  /// up to |eta| = 3
+  const Cylinder ecalBarrel = { 129.0, 317.0 };
+  const Cylinder ecalEndcap = { 152.6, 320.9 };
+
+  /// HCAL entrance : the barrel, or the endcap, up to |eta| = 3
+  const Cylinder hcalBarrel = { 177.5, 335.0 };
+  const Cylinder hcalEndcap = { 300.0, 400.458 };
+
+  /// VFCAL entrance : the HF front face, for 3 < |eta| < 5
+  const Cylinder vfcal = { 400.0, 1110.0 };
+
+  /// HCAL exit, up to |eta| = 3
+  const Cylinder hcalExit = { 285.0, 560.0 };
+
+  /// HO entrance, in no magnetic field : the barrel only, |eta| < 1.26
+  const Cylinder ho = { 387.6, 700.25 };
+
+  /// cos^2(theta) at |eta| = 1.26, 1.479, 3.0 and 5.0
+  const double cos2EtaHO = 0.72466;
+  const double cos2EtaEB = 0.81230;
+  const double cos2Eta3 = 0.99014;
+  const double cos2Eta5 = 0.99981;
+
+  /// The VFCAL is tried rather than the HCAL exit and HO for particles
+  /// beyond this cos^2(theta) at HCAL entrance, or below this energy (GeV)
+  const double vfcalCos2Theta = 0.8;
+  const double vfcalEMax = 3.;
+
+}
+
+#endif // FSimSurfaceGeometry_H
@@ -0,0 +1,80 @@
+#ifndef FastSimulation_Event_FSimSurfaceTable_H
+#define FastSimulation_Event_FSimSurfaceTable_H
+
+// Famos Headers
+#include "FastSimulation/Particle/interface/RawParticle.h"
+
+#include <vector>
+
+/** A sparse table of the particle states at the calorimeter surfaces
+ *  (preshower layers, ECAL, HCAL, VFCAL, HCAL exit and HO), owned by the
+ *  FBaseSimEvent. A state is stored only when a track is actually
+ *  propagated to the corresponding surface: tracks that decay in the
+ *  tracker, or are never propagated, cost only one index per surface.
+ */
+
+class FSimSurfaceTable {
+
+ public:
+
+  /// The calorimeter surfaces, in the order of the propagation
+  enum Surface { LAYER1=0, LAYER2, ECAL, HCAL, VFCAL, HCALEXIT, HO, NSURFACES };
+
+  /// A state computed for a track on a surface, with the propagation
+  /// success, kept aside until it is stored (e.g., after a parallel 
+  /// propagation of the tracks)
+  struct Hit {
+    Hit(int i, Surface s, const RawParticle& pp, int succ) :
+      track(i), surface(s), state(pp), success(succ) {;}
+    int track;
+    Surface surface;
+    RawParticle state;
+    int success;
+  };
+
+  /// Default constructor
+  FSimSurfaceTable();
+
+  /// Forget all the states (the memory is kept for the next event)
+  void clear();
+
+  /// Forget all the states and release the memory
+  void release();
+
+  /// The memory taken by the table, in bytes
+  unsigned long memory() const;
+
+  /// Store the state of track i on surface s (overwrites a previous one)
+  void set(int i, Surface s, const RawParticle& pp);
+
+  /// Was a state stored for track i on surface s ?
+  inline bool has(int i, Surface s) const {
+    return i >= 0 && 
+      (unsigned)(i*NSURFACES+s) < index_.size() && 
+      index_[i*NSURFACES+s] >= 0;
+  }
+
+  /// The state of track i on surface s (a default particle if none)
+  inline const RawParticle& state(int i, Surface s) const {
+    return has(i,s) ? states_[index_[i*NSURFACES+s]] : noState;
+  }
+
+  /// The number of states stored
+  inline unsigned nStates() const { return states_.size(); }
+
+  /// The number of times the table had to grow
+  inline unsigned long nAllocations() const { return nAllocations_; }
+
+  /// The state returned for tracks not propagated to a surface
+  static const RawParticle noState;
+
+ private:
+
+  std::vector<int> index_;           // NSURFACES indices per track in states_, -1 if none
+  std::vector<RawParticle> states_;  // The states actually stored
+
+  unsigned long nAllocations_;
+
+};
+
+#endif // FSimSurfaceTable_H
@@ -9,6 +9,8 @@
 
 // FAMOS headers
 #include "FastSimulation/Particle/interface/RawParticle.h"
+#include "FastSimulation/Event/interface/FSimSurfaceTable.h"
+#include "FastSimulation/Event/interface/FSimDaughterTable.h"
 
 #include <vector>
 
@@ -32,21 +34,19 @@ class FSimTrack : public SimTrack {
   /// Default constructor
   FSimTrack();
   
-  /// Constructor from the EmmbSimTrack index in the FBaseSimEvent
-  FSimTrack(const RawParticle* p, int iv, int ig, int id, FBaseSimEvent* mom, double dt=-1.);
+  /// Constructor from the EmmbSimTrack index in the FBaseSimEvent, with
+  /// the index of the species in the FSimParticleProperties (-1 if none)
+  FSimTrack(const RawParticle* p, int iv, int ig, int id, int species,
+	    FBaseSimEvent* mom, double dt=-1.);
   
   /// Destructor
   virtual ~FSimTrack();
 
   /// particle info...
-  inline const HepPDT::ParticleData* particleInfo() const {
-    return info_;
-  }
+  inline const HepPDT::ParticleData* particleInfo() const;
   
   /// charge
-  inline float charge() const { 
-    return particleInfo()->charge();
-  }
+  inline float charge() const;
   
 
   /// Origin vertex
@@ -64,8 +64,12 @@ class FSimTrack : public SimTrack {
   /// Number of daughters
   inline int nDaughters() const;
 
-  /// Vector of daughter indices
-  inline const std::vector<int>& daughters() const;
+  /// The daughter indices (a copy)
+  inline std::vector<int> daughters() const;
+
+  /// The daughter indices, without copy (valid until the next daughter 
+  /// is added to the event)
+  inline FSimDaughterTable::Range daughterRange() const;
 
   /// no end vertex
   inline bool  noEndVertex() const;
@@ -88,64 +92,64 @@ class FSimTrack : public SimTrack {
   /// The particle was propagated to the Preshower Layer1
   /// 2 : on the EndCaps; (no Barrel Preshower); no propagation possible
   /// 0 : not yet propagated or no pe
-  inline int onLayer1() const { return layer1; }
+  inline int onLayer1() const { propagateTo(FSimSurfaceTable::LAYER1); return layer1; }
 
   /// The particle was propagated to the Preshower Layer2 
   /// 2 : on the EndCaps; (no Barrel Preshower); 3 : No propagation possible
   /// 0 : not yet propagated
-  inline int onLayer2() const { return layer2; }
+  inline int onLayer2() const { propagateTo(FSimSurfaceTable::LAYER2); return layer2; }
 
   /// The particle was propagated to the ECAL front face
   /// 1 : on the barrel; 2 : on the EndCaps; 3 : no propagation possible
   /// 0 : not yet propagated
-  inline int onEcal() const { return ecal; }
+  inline int onEcal() const { propagateTo(FSimSurfaceTable::ECAL); return ecal; }
 
   /// The particle was propagated to the HCAL front face
   /// 1 : on the barrel; 2 : on the EndCaps; 3 : no propagation possible
   /// 0 : not yet propagated
-  inline int onHcal() const { return hcal; }
+  inline int onHcal() const { propagateTo(FSimSurfaceTable::HCAL); return hcal; }
 
   /// The particle was propagated to the VFCAL front face
   /// 2 : on the EndCaps (No VFCAL Barrel); 3 : no propagation possible
   /// 0 : not yet propagated
-  inline int onVFcal() const { return vfcal; }
+  inline int onVFcal() const { propagateTo(FSimSurfaceTable::VFCAL); return vfcal; }
   
   /// The particle was propagated to the HCAL back face
   /// 1 : on the barrel; 2 : on the EndCaps; 3 : no propagation possible
   /// 0 : not yet propagated
-  inline int outHcal() const { return hcalexit; }
+  inline int outHcal() const { propagateTo(FSimSurfaceTable::HCALEXIT); return hcalexit; }
 
   //The particle was propagated to the HO front face
   /// 1 : on the barrel; 2 : on the EndCaps; 3 : no propagation possible
   /// 0 : not yet propagated
-  inline int onHO() const { return hoentr; }
+  inline int onHO() const { propagateTo(FSimSurfaceTable::HO); return hoentr; }
 
   /// The particle was tentatively propagated to calorimeters
   inline bool propagated() const { return prop; }
 
   /// The particle at Preshower Layer 1
-  inline const RawParticle& layer1Entrance() const { return Layer1_Entrance; }
+  inline const RawParticle& layer1Entrance() const { return surfaceState(FSimSurfaceTable::LAYER1); }
 
   /// The particle at Preshower Layer 2
-  inline const RawParticle& layer2Entrance() const { return Layer2_Entrance; }
+  inline const RawParticle& layer2Entrance() const { return surfaceState(FSimSurfaceTable::LAYER2); }
 
   /// The particle at ECAL entrance
-  inline const RawParticle& ecalEntrance() const { return ECAL_Entrance; }
+  inline const RawParticle& ecalEntrance() const { return surfaceState(FSimSurfaceTable::ECAL); }
 
   /// The particle at HCAL entrance
-  inline const RawParticle& hcalEntrance() const { return HCAL_Entrance; }
+  inline const RawParticle& hcalEntrance() const { return surfaceState(FSimSurfaceTable::HCAL); }
 
   /// The particle at VFCAL entrance
-  inline const RawParticle& vfcalEntrance() const { return VFCAL_Entrance; }
+  inline const RawParticle& vfcalEntrance() const { return surfaceState(FSimSurfaceTable::VFCAL); }
 
   /// The particle at HCAL exir
-  inline const RawParticle& hcalExit() const { return HCAL_Exit; }
+  inline const RawParticle& hcalExit() const { return surfaceState(FSimSurfaceTable::HCALEXIT); }
 
   /// The particle at HCAL exir
-  inline const RawParticle& hoEntrance() const { return HO_Entrance; }
+  inline const RawParticle& hoEntrance() const { return surfaceState(FSimSurfaceTable::HO); }
 
   /// Set the end vertex
-  inline void setEndVertex(int endv) { endv_ = endv; } 
+  inline void setEndVertex(int endv);
 
   /// The particle has been propgated through the tracker
   void setPropagate();
@@ -171,6 +175,9 @@ class FSimTrack : public SimTrack {
   /// Set the ho variables
   void setHO(const RawParticle& pp, int success);
 
+  /// Set the variables of surface s (one of the above)
+  void setSurface(FSimSurfaceTable::Surface s, const RawParticle& pp, int success);
+
   /// Add a RecHit for a track on a layer
   //  void addRecHit(const FamosBasicRecHit* hit, unsigned layer);
 
@@ -178,7 +185,7 @@ class FSimTrack : public SimTrack {
   //  void addSimHit(const RawParticle& pp, unsigned layer);
 
   /// Update the vactors of daughter's id
-  inline void addDaughter(int i) { daugh_.push_back(i); }
+  inline void addDaughter(int i);
 
   /// Set the index of the closest charged daughter
   inline void setClosestDaughterId(int id) { closestDaughterId_ = id; }
@@ -187,10 +194,11 @@ class FSimTrack : public SimTrack {
   inline int closestDaughterId() const { return closestDaughterId_; }
 
   /// Temporary (until move of SimTrack to Mathcore) - No! Actually very useful
-  const XYZTLorentzVector& momentum() const { return momentum_; }
+  /// (read from the columnar track store of the FBaseSimEvent)
+  inline const XYZTLorentzVector& momentum() const;
 
   /// Reset the momentum (to be used with care)
-  inline void setMomentum(const math::XYZTLorentzVector& newMomentum) {momentum_ = newMomentum; }
+  inline void setMomentum(const math::XYZTLorentzVector& newMomentum);
 
   /// Simply returns the SimTrack
   inline const SimTrack& simTrack() const { return *this; }
@@ -200,13 +208,24 @@ class FSimTrack : public SimTrack {
 
  private:
 
+  /// The index of the end vertex in FSimVertex (-1 if none)
+  inline int endVertexIndex() const;
+
+  /// The particle state at a calorimeter surface, from the FBaseSimEvent table
+  inline const RawParticle& surfaceState(FSimSurfaceTable::Surface s) const;
+
+  /// In the lazy propagation mode, propagate the track up to surface s 
+  /// if not yet done (see FBaseSimEvent::setLazyPropagation)
+  inline void propagateTo(FSimSurfaceTable::Surface s) const;
+
+  /// Store the particle state at a calorimeter surface in the FBaseSimEvent table
+  void setSurfaceState(FSimSurfaceTable::Surface s, const RawParticle& pp);
+
   //  HepMC::GenParticle* me_;
 
   FBaseSimEvent* mom_;
   //  int embd_;   // The index in the SimTrack vector
   int id_; // The index in the FSimTrackVector
-  
-  int endv_; // The index of the end vertex in FSimVertex
 
   int layer1;// 1 if the particle was propagated to preshower layer1
   int layer2;// 1 if the particle was propagated to preshower layer2
@@ -219,21 +238,16 @@ class FSimTrack : public SimTrack {
 
   bool prop;     // true if the propagation to the calorimeters was done
 
-  RawParticle Layer1_Entrance; // the particle at preshower Layer1
-  RawParticle Layer2_Entrance; // the particle at preshower Layer2
-  RawParticle ECAL_Entrance;   // the particle at ECAL entrance
-  RawParticle HCAL_Entrance;   // the particle at HCAL entrance
-  RawParticle VFCAL_Entrance;  // the particle at VFCAL entrance
-  RawParticle HCAL_Exit;       // the particle at HCAL ezit point
-  RawParticle HO_Entrance;     // the particle at HO entrance
+  // The particle states at the preshower layers, ECAL, HCAL, VFCAL, 
+  // HCAL exit and HO entrance are kept in the FSimSurfaceTable of the
+  // FBaseSimEvent, only for the surfaces actually reached.
 
 
-  std::vector<int> daugh_; // The indices of the daughters in FSimTrack
+  // The indices of the daughters are in the track FSimDaughterTable 
+  // of the FBaseSimEvent
   int closestDaughterId_; // The index of the closest daughter id
 
-  const HepPDT::ParticleData* info_; // The PDG info
-
-  XYZTLorentzVector momentum_;
+  int species_; // The index of the species in the FSimParticleProperties
 
   double properDecayTime; // The proper decay time  (default is -1)
 
@@ -0,0 +1,98 @@
+#ifndef FastSimulation_Event_FSimTrackColumns_H
+#define FastSimulation_Event_FSimTrackColumns_H
+
+// Data Formats
+#include "DataFormats/Math/interface/LorentzVector.h"
+
+#include <vector>
+
+/** Columnar (structure-of-arrays) storage of the FSimTrack quantities
+ *  used in the per-event scans: momentum, particle type, charge, origin
+ *  and end vertex indices, and generator index. Each quantity is stored
+ *  in its own contiguous array, indexed by the FSimTrack id, so that
+ *  loops over all tracks only stream the quantities they actually read.
+ *
+ *  The FSimTrack's owned by the FBaseSimEvent read their momentum and
+ *  end vertex index from here.
+ */
+
+class FSimTrackColumns {
+
+ public:
+
+  /// Default constructor
+  FSimTrackColumns();
+
+  /// Make room for n tracks (without filling them)
+  void reserve(unsigned n);
+
+  /// Forget all the tracks (the memory is kept for the next event)
+  void clear();
+
+  /// The number of tracks
+  inline unsigned size() const { return type_.size(); }
+
+  /// The number of tracks that fit without reallocation
+  inline unsigned capacity() const { return type_.capacity(); }
+
+  /// Append a track (with no end vertex yet)
+  void add(const math::XYZTLorentzVector& p,
+	   int type, float charge, int iv, int ig);
+
+  /// Release the memory, and make room for n tracks
+  void release(unsigned n);
+
+  /// The memory taken by the columns, in bytes
+  unsigned long memory() const;
+
+  /// The number of times the columns had to grow
+  inline unsigned long nAllocations() const { return nAllocations_; }
+
+  /// The momentum of track i
+  inline const math::XYZTLorentzVector& momentum(int i) const { return momentum_[i]; }
+
+  /// The PDG id of track i
+  inline int type(int i) const { return type_[i]; }
+
+  /// The charge of track i
+  inline float charge(int i) const { return charge_[i]; }
+
+  /// The origin vertex index of track i
+  inline int vertex(int i) const { return vertex_[i]; }
+
+  /// The end vertex index of track i (-1 if none)
+  inline int endVertex(int i) const { return endVertex_[i]; }
+
+  /// The generator particle index of track i
+  inline int genpart(int i) const { return genpart_[i]; }
+
+  /// Reset the momentum of track i
+  inline void setMomentum(int i, const math::XYZTLorentzVector& p) { momentum_[i] = p; }
+
+  /// Set the end vertex index of track i
+  inline void setEndVertex(int i, int iv) { endVertex_[i] = iv; }
+
+  /// Direct access to the columns, for loops over all tracks
+  inline const math::XYZTLorentzVector* momenta() const { return momentum_.data(); }
+  inline const int* types() const { return type_.data(); }
+  inline const float* charges() const { return charge_.data(); }
+  inline const int* vertices() const { return vertex_.data(); }
+  inline const int* endVertices() const { return endVertex_.data(); }
+
+  /// The momentum reported by tracks not attached to an event
+  static const math::XYZTLorentzVector nullMomentum;
+
+ private:
+
+  std::vector<math::XYZTLorentzVector> momentum_;
+  std::vector<int> type_;
+  std::vector<float> charge_;
+  std::vector<int> vertex_;
+  std::vector<int> endVertex_;
+  std::vector<int> genpart_;
+
+  unsigned long nAllocations_;
+
+};
+
+#endif // FSimTrackColumns_H
@@ -0,0 +1,63 @@
+#ifndef FastSimulation_Event_FSimTrackIdTable_H
+#define FastSimulation_Event_FSimTrackIdTable_H
+
+#include <vector>
+
+class SimTrack;
+
+/** The association between the Geant track ids of a vector of SimTrack's
+ *  and their positions in the vector, used by FBaseSimEvent to find the
+ *  mother track of each SimVertex. The Geant track ids are most often
+ *  small, dense integers: they are then used directly as indices in an
+ *  array. Otherwise (e.g., ids offset for pile-up events), an open
+ *  addressing hash table is used. The memory is kept from one event to
+ *  the next.
+ */
+
+class FSimTrackIdTable {
+
+ public:
+
+  /// Default constructor
+  FSimTrackIdTable();
+
+  /// Associate the track ids of these SimTrack's to their positions
+  /// (the last one wins if an id appears twice)
+  void fill(const std::vector<SimTrack>& simTracks);
+
+  /// The position of the SimTrack with this track id (-1 if none)
+  inline int find(unsigned trackId) const {
+    if ( dense_ ) return trackId < direct_.size() ? direct_[trackId] : -1;
+    return findHashed(trackId);
+  }
+
+  /// Release the memory
+  void release();
+
+  /// The memory taken by the table, in bytes
+  unsigned long memory() const;
+
+  /// The number of times the table had to grow
+  inline unsigned long nAllocations() const { return nAllocations_; }
+
+ private:
+
+  bool dense_;                   // Direct indexing ?
+  std::vector<int> direct_;      // Track id -> position (dense ids)
+  std::vector<unsigned> keys_;   // Track ids (hash table)
+  std::vector<int> values_;      // Positions, -1 for empty slots (hash table)
+  unsigned bits_;                // log2 of the hash table size
+
+  unsigned long nAllocations_;
+
+  /// The first slot for a track id in the hash table
+  inline unsigned slot(unsigned trackId) const {
+    return (trackId * 2654435761U) >> (32-bits_);
+  }
+
+  /// The position of the SimTrack with this track id, from the hash table
+  int findHashed(unsigned trackId) const;
+
+};
+
+#endif // FSimTrackIdTable_H
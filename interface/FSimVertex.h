@@ -5,6 +5,9 @@
 #include "SimDataFormats/Vertex/interface/SimVertex.h"
 #include "DataFormats/Math/interface/LorentzVector.h"
 
+// FAMOS headers
+#include "FastSimulation/Event/interface/FSimDaughterTable.h"
+
 #include <vector>
 
 class FBaseSimEvent;
@@ -28,11 +31,15 @@ public:
   /// parent track
   inline const FSimTrack& parent() const;
 
-  /// The vector of daughter indices
-  inline const std::vector<int>& daughters() const { return daugh_; }
+  /// The daughter indices (a copy)
+  inline std::vector<int> daughters() const;
+
+  /// The daughter indices, without copy (valid until the next daughter 
+  /// is added to the event)
+  inline FSimDaughterTable::Range daughterRange() const;
 
   /// The number of daughters
-  inline int nDaughters() const { return daugh_.size(); }
+  inline int nDaughters() const;
 
   /// ith daughter
   inline const FSimTrack& daughter(int i) const;
@@ -43,7 +50,7 @@ public:
   /// the index in FBaseSimEvent
   inline int id() const { return id_; }
 
-  inline void addDaughter(int i) { daugh_.push_back(i); }
+  inline void addDaughter(int i);
 
   /// Temporary (until CMSSW moves to Mathcore) - No  ! Actually very useful
   inline const math::XYZTLorentzVector& position() const { return position_; }
@@ -56,9 +63,10 @@ public:
 
  private:
 
-  const FBaseSimEvent* mom_;
+  FBaseSimEvent* mom_;
   int id_;    // The index in the FSimVertex vector
-  std::vector<int> daugh_; // The indices of the daughters in FSimTrack
+  // The indices of the daughters are in the vertex FSimDaughterTable 
+  // of the FBaseSimEvent
 
   math::XYZTLorentzVector position_;
 
@@ -25,6 +25,9 @@ public:
   /// Generation process (to be implemented)
   virtual void generate();
 
+  /// Generation of n vertices at once
+  virtual void generateBatch(unsigned n, Batch& out);
+
  private:
 
   // The smearing quantities in all three directions
@@ -9,8 +9,8 @@
  * \author Patrick Janot
  */
 
-
-#include <set>
+#include <iosfwd>
+#include <vector>
 
 namespace edm { 
   class ParameterSet;
@@ -19,21 +19,99 @@ namespace edm {
 class KineParticleFilter : public BaseRawParticleFilter {
 public:
   KineParticleFilter(const edm::ParameterSet& kine); 
-  virtual ~KineParticleFilter(){;};
+  virtual ~KineParticleFilter();
 
   void setMainVertex(const XYZTLorentzVector& mv) { mainVertex=mv; }
 
   const XYZTLorentzVector& vertex() const { return mainVertex; }
 
+  /// The classification of the species, by |PDG id|: simulated at all 
+  /// (i.e., not a quark, gluon, gauge boson, string, diquark...), 
+  /// and not forbidden by the configuration
+  enum Species { SIMULABLE=1, ALLOWED=2 };
+
+  /// Select the particles in the acceptance, from arrays of n particles
+  /// (momenta and energies, origin vertices in cm, PDG ids and charges),
+  /// with the same cuts as accept(), all applied at once for each 
+  /// particle: mask[i] is set to 1 if particle i is accepted, to 0 
+  /// otherwise. Returns the number of particles accepted. Entries with
+  /// pdgId 0 (e.g. padding) are rejected, and not counted.
+  unsigned acceptBatch(unsigned n,
+		       const double* px, const double* py, const double* pz, 
+		       const double* e,
+		       const double* x, const double* y, const double* z,
+		       const int* pdgId, const double* charge, 
+		       int* mask) const;
+
+  /// The reasons for which particles (and vertices) are rejected: 
+  /// species not simulated, forbidden PDG code, energy, pT, eta, origin 
+  /// vertex beyond the ECAL entrance, and vertex beyond the ECAL entrance
+  enum Rejection { SPECIES, FORBIDDEN, ENERGY, PT, ETA, ORIGIN, VERTEX, 
+		   NREJECTIONS };
+
+  /// The numbers of particles and vertices tested, and rejected for 
+  /// each reason
+  struct Counters { 
+    Counters();
+    Counters& operator+=(const Counters& c);
+    unsigned long nParticles;
+    unsigned long nVertices;
+    unsigned long rejected[NREJECTIONS];
+  };
+
+  /// The counts since the construction, summed over all threads (only
+  /// kept if printRejectionSummary is set)
+  Counters counters() const;
+
+  /// Print the counts as a table
+  void printCounters(std::ostream& out) const;
+
+  /// At the end of the job, report the counts through the MessageLogger
+  /// (if printRejectionSummary is set), to be called by the owner of the 
+  /// filter, e.g. through FBaseSimEvent::endJob()
+  void endJob() const;
+
+  /// The name of a rejection reason
+  static const char* name(Rejection r);
+
+  /// Is a species (|PDG id| > 0) simulated at all ?
+  static bool simulable(int pId);
+
+  /// The classification of a species (|PDG id| > 0)
+  inline unsigned species(int pId) const { 
+    return pId < NSPECIES ? speciesTable[pId] : exoticSpecies(pId);
+  }
+
 private:
   /// the real selection is done here
   virtual bool isOKForMe(const RawParticle* p) const;
 
+  /// The first cut that rejects the particle (or the vertex, if its 
+  /// PDG id is 0), NREJECTIONS if it is accepted
+  Rejection rejection(const RawParticle* p) const;
+
+  /// The classification of the species above the table
+  unsigned exoticSpecies(int pId) const;
+
   double etaMin, etaMax, phiMin, phiMax, pTMin, pTMax, EMin, EMax;
   double cos2Max, cos2PreshMin, cos2PreshMax;
   XYZTLorentzVector mainVertex;
 
-  std::set<int>   forbiddenPdgCodes;
+  /// The classification of the species below NSPECIES, and the sorted
+  /// forbidden PDG codes above
+  enum { NSPECIES=10000 };
+  std::vector<unsigned char> speciesTable;
+  std::vector<int> forbiddenExoticCodes;
+
+  /// The counts, for each thread (a TBB enumerable_thread_specific, 
+  /// with one TLS key per filter: see KineParticleFilter.cc)
+  class ThreadCounters;
+  ThreadCounters* threadCounters;
+  bool printSummary;
+
+  /// The counters are not copied
+  KineParticleFilter(const KineParticleFilter&);
+  KineParticleFilter& operator=(const KineParticleFilter&);
 };
 
 #endif
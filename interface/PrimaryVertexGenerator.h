@@ -4,9 +4,15 @@
 // Data Format Headers
 #include "DataFormats/Math/interface/Vector3D.h"
 #include "DataFormats/Math/interface/Point3D.h"
-#include "TMatrixD.h"
+#include "TMatrixDfwd.h"
+
+// Famos Headers
+#include "FastSimulation/Event/interface/CrossingAngleBoost.h"
+
+#include <vector>
 
 class RandomEngine;
+class CounterBasedRandom;
 
 /** A class that generates a primary vertex for the event, in cm*/ 
 
@@ -23,18 +29,86 @@ public:
   /// Generation process (to be implemented)
   virtual void generate() = 0;
 
+  /// A batch of vertices, in cm (the times in cm/c), as arrays
+  struct Batch { 
+    std::vector<double> x, y, z, t;
+    void resize(unsigned n) { x.resize(n); y.resize(n); z.resize(n); t.resize(n); }
+    unsigned size() const { return x.size(); }
+  };
+
+  /// Generate n vertices at once (e.g., for the pile-up interactions of
+  /// an event). By default, generate() is called n times: the generators
+  /// redefine it to draw all the random numbers in bulk, and to compute
+  /// the vertices in loops the compiler can vectorize. The vertex 
+  /// generated last by generate() is not changed.
+  virtual void generateBatch(unsigned n, Batch& out);
+
+  /// Draw the random numbers from a counter-based generator, keyed by
+  /// this seed and by (run, lumi, event, interaction index) instead of 
+  /// from the shared RandomEngine: each vertex is then the same whatever 
+  /// the order of the calls, the batch sizes, or the threads.
+  void setCounterBasedSeed(unsigned seed);
+  inline bool counterBased() const { return counterBased_ != 0; }
+
+  /// The event the next vertices are generated for (their interaction 
+  /// indices start again from 0). Only used with counter-based numbers.
+  void setEvent(unsigned run, unsigned lumi, unsigned long long event);
+
+  /// The boost from the head-on frame to the laboratory (0 if none)
+  inline const CrossingAngleBoost* lorentzBoost() const { return boosted_ ? &boost_ : 0; }
+
+  /// Apply this boost to n four-vectors, given as four arrays, in place
+  /// (nothing is done if there is no boost)
+  void applyBoost(unsigned n, double* x, double* y, double* z, double* t) const;
+
+  /// The same boost, as a ROOT matrix (0 if none), made in setBoost, 
+  /// for the code still using TMatrixD's (prefer applyBoost)
   TMatrixD* boost() const;
 
+  /// The time of the vertex, in cm/c (0 if not generated)
+  inline double time() const { return time_; }
+
   /// Return x0, y0, z0
   inline const math::XYZPoint& beamSpot() const { return beamSpot_; }
 
  protected:
 
-  void setBoost(TMatrixD*);
+  /// Set the boost, and make its ROOT matrix at once (so that boost() 
+  /// can be called concurrently)
+  void setBoost(const CrossingAngleBoost& aBoost);
+
+  /// nPerVertex random numbers for each of nVertices vertices, flat in 
+  /// ]0,1] or Gaussian (mean 0, sigma 1), drawn in bulk (valid until the 
+  /// next call). Number k of vertex i is at [k*nVertices+i]. With 
+  /// counter-based numbers, each call is for the next nVertices 
+  /// interactions of the event, and nPerVertex is at most 8.
+  const double* flats(unsigned nVertices, unsigned nPerVertex);
+  const double* gaussians(unsigned nVertices, unsigned nPerVertex);
+
+  /// With counter-based numbers, set the vertex from generateBatch(1),
+  /// and return true (to be called first by the generate() of the 
+  /// generators that redefine generateBatch).
+  bool generateFromStream();
 
   const RandomEngine* random;
-  TMatrixD* boost_;
   math::XYZPoint beamSpot_;
+  double time_;
+
+ private:
+
+  CrossingAngleBoost boost_;
+  bool boosted_;
+  TMatrixD* rootBoost_;
+
+  std::vector<double> flats_;
+  std::vector<double> gaussians_;
+  CounterBasedRandom* counterBased_;
+  unsigned interaction_;
+  Batch one_;
+
+  /// Not copyable: the ROOT matrix and the counter-based numbers are owned
+  PrimaryVertexGenerator(const PrimaryVertexGenerator&);
+  PrimaryVertexGenerator& operator=(const PrimaryVertexGenerator&);
 
 };
 
@@ -0,0 +1,74 @@
+#ifndef FastSimulation_Event_TabulatedPrimaryVertexGenerator_H
+#define FastSimulation_Event_TabulatedPrimaryVertexGenerator_H
+
+// Famos Headers
+#include "FastSimulation/Event/interface/PrimaryVertexGenerator.h"
+
+#include <vector>
+
+/** A class that generates a primary vertex according to a measured
+ *  profile of the luminous region, in cm, given as a 3D histogram (e.g.,
+ *  of the reconstructed vertices): the bin edges in x, y and z, and the
+ *  bin contents. An axis with a single bin is flat within this bin (a 2D 
+ *  or 1D profile). An alias table of the bins is made at construction,
+ *  so that a vertex takes a fixed number of operations, whatever the
+ *  number of bins: a bin is chosen, and the vertex is flat within it.
+ */
+
+class RandomEngine;
+
+namespace edm { 
+  class ParameterSet;
+}
+
+class TabulatedPrimaryVertexGenerator : public PrimaryVertexGenerator {
+
+public:
+  /// Default constructor (throws a cms::Exception if the bin edges do 
+  /// not increase, or if a content is negative, infinite or not a number)
+  TabulatedPrimaryVertexGenerator(const edm::ParameterSet& vtx,
+				  const RandomEngine* engine);
+
+  /// Destructor
+  ~TabulatedPrimaryVertexGenerator() {;}
+  
+  /// Generation process (to be implemented)
+  virtual void generate();
+
+  /// Generation of n vertices at once
+  virtual void generateBatch(unsigned n, Batch& out);
+
+  /// The number of bins with a non-zero content
+  inline unsigned size() const { return prob_.size(); }
+
+ private:
+
+  /// The vertex from four random numbers, flat in ]0,1]
+  inline void sample(double u0, double u1, double u2, double u3,
+		     double& x, double& y, double& z) const { 
+    // The bin, from the alias table: u0 gives both the column and the
+    // probability to keep it
+    double column = u0 * prob_.size();
+    unsigned k = (unsigned)column;
+    if ( k >= prob_.size() ) k = prob_.size()-1;
+    unsigned bin = column-k < prob_[k] ? bin_[k] : bin_[alias_[k]];
+    unsigned ix = bin % nx_;
+    unsigned iy = (bin / nx_) % ny_;
+    unsigned iz = bin / (nx_*ny_);
+    x = edgesX_[ix] + (edgesX_[ix+1]-edgesX_[ix]) * u1;
+    y = edgesY_[iy] + (edgesY_[iy+1]-edgesY_[iy]) * u2;
+    z = edgesZ_[iz] + (edgesZ_[iz+1]-edgesZ_[iz]) * u3;
+  }
+
+  // The histogram binning
+  std::vector<double> edgesX_, edgesY_, edgesZ_;
+  unsigned nx_, ny_, nz_;
+
+  // The alias table: one column per non-empty bin
+  std::vector<double> prob_;     // The probability to keep the column
+  std::vector<unsigned> alias_;  // The column taken otherwise
+  std::vector<unsigned> bin_;    // The global bin of each column
+
+};
+
+#endif // TabulatedPrimaryVertexGenerator_H
@@ -0,0 +1,21 @@
+import FWCore.ParameterSet.Config as cms
+
+myVertexGenerator = cms.PSet(
+    # half-crossing beam angle
+    Phi = cms.double(0.000142),
+    BetaStar = cms.double(55.0),
+    type = cms.string('BetaFunc4D'),
+    Emittance = cms.double(5.03e-08),
+    # angle of the crossing plane 0 degrees means XZ plane
+    Alpha = cms.double(0.0),
+    # not used: the length of the luminous region follows from BunchLength
+    SigmaZ = cms.double(7.55),
+    # rms length of each bunch (cm)
+    BunchLength = cms.double(10.68),
+    # time between two bunch crossings (ns)
+    BunchSpacing = cms.double(25.0),
+    Y0 = cms.double(0.0),
+    # Units are cm and radians
+    X0 = cms.double(0.05),
+    Z0 = cms.double(0.0)
+)
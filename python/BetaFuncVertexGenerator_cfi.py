@@ -12,6 +12,9 @@ myVertexGenerator = cms.PSet(
     Y0 = cms.double(0.0),
     # Units are cm and radians
     X0 = cms.double(0.05),
-    Z0 = cms.double(0.0)
+    Z0 = cms.double(0.0),
+    # Optional: counter-based random numbers, keyed by this seed and by
+    # (run, lumi, event, interaction), for reproducible vertices
+    # counterBasedSeed = cms.uint32(1)
 )
 
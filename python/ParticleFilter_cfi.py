@@ -10,7 +10,34 @@ ParticleFilterBlock = cms.PSet(
         # Charged particles with pT < pTMin (GeV/c) are not simulated
         pTMin = cms.double(0.2),
         # Particles with energy smaller than EMin (GeV) are not simulated
-        EMin = cms.double(0.1)
+        EMin = cms.double(0.1),
+        # Report the numbers of particles rejected by each cut at the end of 
+        # the job (MessageLogger, LogInfo category KineParticleFilter)
+        printRejectionSummary = cms.untracked.bool(False),
+        # Propagate the tracks filled from SimTrack's to the calorimeters
+        # in parallel (TBB), by blocks of tracksPerBlock tracks
+        parallelPropagation = cms.untracked.bool(False),
+        tracksPerBlock = cms.untracked.uint32(64),
+        # Propagate the tracks to the calorimeters with the analytical
+        # batch propagator (FSimBatchPropagator)
+        batchPropagation = cms.untracked.bool(False),
+        # Propagate each track to a calorimeter surface only when its state
+        # there is first read (FBaseSimEvent::setLazyPropagation)
+        lazyPropagation = cms.untracked.bool(False),
+        # The sizing of the event buffers (FSimEventCapacityPolicy)
+        CapacityPolicy = cms.untracked.PSet(
+            # The room preallocated before the first event
+            initialSize = cms.untracked.uint32(5000),
+            # The buffers are sized to the percentile of the sizes of the
+            # last window events, times headroom
+            window = cms.untracked.uint32(100),
+            percentile = cms.untracked.double(0.95),
+            headroom = cms.untracked.double(1.2),
+            # A buffer larger than outlierFactor times that size is released
+            # after releaseAfter events that fit
+            outlierFactor = cms.untracked.double(2.0),
+            releaseAfter = cms.untracked.uint32(50)
+        )
     )
 )
 
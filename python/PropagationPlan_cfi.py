@@ -0,0 +1,65 @@
+import FWCore.ParameterSet.Config as cms
+
+# The propagation of the tracks filled from SimTrack's to the calorimeter 
+# surfaces (FSimPropagationPlan). The default reproduces the historical 
+# behaviour: all surfaces, for all particles, in a 4 T field.
+# A surface without a PSet is not computed.
+# FBaseSimEvent reads it from the ParticleFilter PSet, if present, e.g.
+#   ParticleFilter.PropagationPlan = PropagationPlanBlock.PropagationPlan
+PropagationPlanBlock = cms.PSet(
+    PropagationPlan = cms.PSet(
+        # Magnetic field (T)
+        bField = cms.double(4.0),
+        # Particles (|PDG id|) never propagated, e.g. [12, 14, 16] for neutrinos
+        skippedParticles = cms.vint32(),
+        # Preshower layers
+        Layer1 = cms.PSet(
+            propagate = cms.bool(True),
+            # Minimal pT and energy at the tracker surface (GeV)
+            pTMin = cms.double(0.0),
+            EMin = cms.double(0.0),
+            # The only particles (|PDG id|) propagated, all if empty
+            particles = cms.vint32()
+        ),
+        Layer2 = cms.PSet(
+            propagate = cms.bool(True),
+            pTMin = cms.double(0.0),
+            EMin = cms.double(0.0),
+            particles = cms.vint32()
+        ),
+        # ECAL and HCAL entrances
+        Ecal = cms.PSet(
+            propagate = cms.bool(True),
+            pTMin = cms.double(0.0),
+            EMin = cms.double(0.0),
+            particles = cms.vint32()
+        ),
+        Hcal = cms.PSet(
+            propagate = cms.bool(True),
+            pTMin = cms.double(0.0),
+            EMin = cms.double(0.0),
+            particles = cms.vint32()
+        ),
+        # Forward calorimeter entrance (for cos^2(theta) > 0.8 or E < 3 GeV)
+        VFcal = cms.PSet(
+            propagate = cms.bool(True),
+            pTMin = cms.double(0.0),
+            EMin = cms.double(0.0),
+            particles = cms.vint32()
+        ),
+        # HCAL exit and HO entrance (for the other particles), 
+        # e.g. particles = [13] for HO to propagate only muons
+        HcalExit = cms.PSet(
+            propagate = cms.bool(True),
+            pTMin = cms.double(0.0),
+            EMin = cms.double(0.0),
+            particles = cms.vint32()
+        ),
+        HO = cms.PSet(
+            propagate = cms.bool(True),
+            pTMin = cms.double(0.0),
+            EMin = cms.double(0.0),
+            particles = cms.vint32()
+        )
+    )
+)
@@ -0,0 +1,36 @@
+import FWCore.ParameterSet.Config as cms
+
+# A luminous region given as a 3D histogram, e.g. of the reconstructed
+# primary vertices (TabulatedPrimaryVertexGenerator). The vertices are
+# flat within each bin; an axis with a single bin gives a 2D or 1D profile.
+# The profile below is only a placeholder (Gaussian, as in the 
+# GaussianVertexGenerator): replace it with the measured one, e.g. from
+# a TH3 h:
+#   BinEdgesX = [h.GetXaxis().GetBinLowEdge(i) for i in range(1,h.GetNbinsX()+2)]
+#   Contents = [h.GetBinContent(ix,iy,iz) for iz in range(1,h.GetNbinsZ()+1)
+#               for iy in range(1,h.GetNbinsY()+1) for ix in range(1,h.GetNbinsX()+1)]
+import math
+
+def _edges(mean,sigma,nBins):
+    return [mean+sigma*(-3.+6.*i/nBins) for i in range(nBins+1)]
+
+def _weights(edges,mean,sigma):
+    cdf = [math.erf((e-mean)/(sigma*math.sqrt(2.))) for e in edges]
+    return [cdf[i+1]-cdf[i] for i in range(len(edges)-1)]
+
+_x = _edges(0.0322,0.0015,6)
+_y = _edges(0.0,0.0015,6)
+_z = _edges(0.0,5.3,24)
+
+myVertexGenerator = cms.PSet(
+    type = cms.string('Tabulated'),
+    # Units are cm
+    BinEdgesX = cms.vdouble(*_x),
+    BinEdgesY = cms.vdouble(*_y),
+    BinEdgesZ = cms.vdouble(*_z),
+    # x runs fastest, then y, then z
+    Contents = cms.vdouble(*[wx*wy*wz 
+                             for wz in _weights(_z,0.0,5.3)
+                             for wy in _weights(_y,0.0,0.0015)
+                             for wx in _weights(_x,0.0322,0.0015)])
+)
@@ -0,0 +1,71 @@
+//Framework Headers
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+//Famos Headers
+#include "FastSimulation/Event/interface/BetaFunc4DPrimaryVertexGenerator.h"
+
+#include <cmath>
+
+BetaFunc4DPrimaryVertexGenerator::BetaFunc4DPrimaryVertexGenerator(
+  const edm::ParameterSet& vtx, const RandomEngine* engine) : 
+  BetaFuncPrimaryVertexGenerator(vtx,engine),
+  bunchLength_(vtx.exists("BunchLength") ? 
+	       vtx.getParameter<double>("BunchLength") : std::sqrt(2.)*fSigmaZ),
+  // From ns to cm/c
+  bunchSpacing_(29.9792458 * 
+		(vtx.exists("BunchSpacing") ? vtx.getParameter<double>("BunchSpacing") : 25.))
+{
+
+  cosAlpha_ = std::cos(alpha_);
+  sinAlpha_ = std::sin(alpha_);
+  cosPhi_ = std::cos(phi_);
+  sinPhi_ = std::sin(phi_);
+
+  // The overlap of the two bunches along the beams, and of the two beams 
+  // (of width sigma* at the focus) in the crossing plane
+  double sigmaS2 = bunchLength_*bunchLength_;
+  double sigmaStar2 = femittance*fbetastar;
+  sigmaZ_ = 1./std::sqrt(2.*cosPhi_*cosPhi_/sigmaS2 + 2.*sinPhi_*sinPhi_/sigmaStar2);
+  // The time of the collision, around the crossing time
+  sigmaT_ = bunchLength_ * 0.707107;
+
+}
+
+void
+BetaFunc4DPrimaryVertexGenerator::generate() {
+
+  generateBatch(1,vertex_);
+  this->SetXYZ(vertex_.x[0],vertex_.y[0],vertex_.z[0]);
+  time_ = vertex_.t[0];
+
+}
+
+void
+BetaFunc4DPrimaryVertexGenerator::generateBatch(unsigned n, Batch& out) {
+
+  out.resize(n);
+  const double* g = gaussians(n,4);
+  for ( unsigned i=0; i<n; ++i ) {
+    double z = sigmaZ_ * g[i];
+    // The transverse width at z (hourglass), divided by sqrt(2) for the
+    // overlap of the two beams, and by cos(phi) along the crossing plane
+    double sigma = 0.707107 * std::sqrt(femittance*(fbetastar+z*z/fbetastar));
+    double s = sigma/cosPhi_ * g[n+i];
+    double p = sigma * g[2*n+i];
+    out.x[i] = fX0 + s*cosAlpha_ - p*sinAlpha_;
+    out.y[i] = fY0 + s*sinAlpha_ + p*cosAlpha_;
+    out.z[i] = fZ0 + z;
+    // The bunches meet earlier on one side of the crossing plane
+    out.t[i] = s*sinPhi_ + sigmaT_ * g[3*n+i];
+  }
+
+}
+
+void
+BetaFunc4DPrimaryVertexGenerator::generateCrossing(int bunchCrossing, unsigned n, Batch& out) {
+
+  generateBatch(n,out);
+  double t0 = bunchCrossing * bunchSpacing_;
+  for ( unsigned i=0; i<n; ++i ) out.t[i] += t0;
+
+}
@@ -5,6 +5,8 @@
 #include "FastSimulation/Event/interface/BetaFuncPrimaryVertexGenerator.h"
 #include "FastSimulation/Utilities/interface/RandomEngine.h"
 
+#include <cmath>
+
 BetaFuncPrimaryVertexGenerator::BetaFuncPrimaryVertexGenerator(
   const edm::ParameterSet& vtx, const RandomEngine* engine) : 
   PrimaryVertexGenerator(engine),
@@ -18,13 +20,17 @@ BetaFuncPrimaryVertexGenerator::BetaFuncPrimaryVertexGenerator(
   femittance(vtx.getParameter<double>("Emittance"))
 {
 
-  this->setBoost(inverseLorentzBoost());
+  // The inverse of the boost to the frame where the collision is head-on
+  if ( fabs(alpha_) >= 1E-12 || fabs(phi_) >= 1E-12 ) 
+    this->setBoost(CrossingAngleBoost(alpha_,phi_).inverse());
   beamSpot_ = math::XYZPoint(fX0,fY0,fZ0);
 
 } 
   
 
 void BetaFuncPrimaryVertexGenerator::generate() {	
+
+  if ( generateFromStream() ) return;
   
   double tmp_sigz = random->gaussShoot(0., fSigmaZ);
   this->SetZ(tmp_sigz + fZ0);
@@ -41,50 +47,26 @@ void BetaFuncPrimaryVertexGenerator::generate() {
 
 }
 
+void 
+BetaFuncPrimaryVertexGenerator::generateBatch(unsigned n, Batch& out) {
+
+  out.resize(n);
+  const double* g = gaussians(n,3);
+  for ( unsigned i=0; i<n; ++i ) {
+    double tmp_sigz = fSigmaZ * g[i];
+    out.z[i] = tmp_sigz + fZ0;
+    // The same width in x and y, divided by sqrt(2) as in generate()
+    double tmp_sig = 0.707107 * std::sqrt(femittance*(fbetastar+(((tmp_sigz-fZ0)*(tmp_sigz-fZ0))/fbetastar)));
+    out.x[i] = fX0 + tmp_sig * g[n+i];
+    out.y[i] = fY0 + tmp_sig * g[2*n+i];
+    out.t[i] = 0.;
+  }
+
+}
+
 double BetaFuncPrimaryVertexGenerator::BetaFunction(double z, double z0)
 {
   return sqrt(femittance*(fbetastar+(((z-z0)*(z-z0))/fbetastar)));
 
 }
 
-
-TMatrixD* 
-BetaFuncPrimaryVertexGenerator::inverseLorentzBoost() {
-  
-  TMatrixD* aBoost = 0;
-  if ( fabs(alpha_) < 1E-12 && fabs(phi_) < 1E-12 ) return aBoost;
- 
-  TMatrixD tmpboost(4,4);
-  
-  // Lorentz boost to frame where the collision is head-on
-  // phi is the half crossing angle in the plane ZS
-  // alpha is the angle to the S axis from the X axis in the XY plane
-
-  double calpha = std::cos(alpha_);
-  double salpha = std::sin(alpha_);
-  double cphi = std::cos(phi_);
-  double sphi = std::sin(phi_);
-  double tphi = sphi/cphi;
-  tmpboost(0,0) = 1./cphi;
-  tmpboost(0,1) = - calpha*sphi;
-  tmpboost(0,2) = - tphi*sphi;
-  tmpboost(0,3) = - salpha*sphi;
-  tmpboost(1,0) = - calpha*tphi;
-  tmpboost(1,1) = 1.;
-  tmpboost(1,2) = calpha*tphi;
-  tmpboost(1,3) = 0.;
-  tmpboost(2,0) = 0.;
-  tmpboost(2,1) = -calpha*sphi;
-  tmpboost(2,2) = cphi;
-  tmpboost(2,3) = - salpha*sphi;
-  tmpboost(3,0) = - salpha*tphi;
-  tmpboost(3,1) = 0.;
-  tmpboost(3,2) = salpha*tphi;
-  tmpboost(3,3) = 1.;
-  
-  tmpboost.Invert();
-  aBoost = new TMatrixD(tmpboost);
-
-  return aBoost;
-
-}
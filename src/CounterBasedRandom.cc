@@ -0,0 +1,56 @@
+//Famos Headers
+#include "FastSimulation/Event/interface/CounterBasedRandom.h"
+
+namespace { 
+
+  // The Philox4x32 constants
+  const uint32_t M0 = 0xD2511F53;
+  const uint32_t M1 = 0xCD9E8D57;
+  const uint32_t W0 = 0x9E3779B9;
+  const uint32_t W1 = 0xBB67AE85;
+
+  inline void round(uint32_t c[4], const uint32_t k[2]) { 
+    uint64_t p0 = (uint64_t)M0 * c[0];
+    uint64_t p1 = (uint64_t)M1 * c[2];
+    uint32_t c0 = (uint32_t)(p1>>32) ^ c[1] ^ k[0];
+    uint32_t c2 = (uint32_t)(p0>>32) ^ c[3] ^ k[1];
+    c[1] = (uint32_t)p1;
+    c[3] = (uint32_t)p0;
+    c[0] = c0;
+    c[2] = c2;
+  }
+
+}
+
+CounterBasedRandom::CounterBasedRandom(unsigned seed) {
+  key_[0] = seed;
+  setEvent(0,0,0);
+}
+
+void
+CounterBasedRandom::setEvent(unsigned run, unsigned lumi, unsigned long long event) { 
+  key_[1] = run;
+  event_[0] = lumi;
+  event_[1] = (uint32_t)event;
+  event_[2] = (uint32_t)(event>>32);
+}
+
+void
+CounterBasedRandom::block(unsigned stream, unsigned block, uint32_t words[4]) const { 
+
+  // The counter: (stream, block), luminosity block, event number
+  words[0] = (stream<<2) + block;
+  words[1] = event_[0];
+  words[2] = event_[1];
+  words[3] = event_[2];
+
+  // Ten rounds, with the key bumped in between
+  uint32_t k[2] = { key_[0], key_[1] };
+  for ( unsigned r=0; r<9; ++r ) { 
+    round(words,k);
+    k[0] += W0;
+    k[1] += W1;
+  }
+  round(words,k);
+
+}
@@ -0,0 +1,100 @@
+//Famos Headers
+#include "FastSimulation/Event/interface/CrossingAngleBoost.h"
+
+#include <cmath>
+
+CrossingAngleBoost::CrossingAngleBoost() { 
+  for ( unsigned i=0; i<4; ++i ) 
+    for ( unsigned j=0; j<4; ++j ) 
+      m_[i][j] = i == j ? 1. : 0.;
+}
+
+CrossingAngleBoost::CrossingAngleBoost(double alpha, double phi) { 
+
+  // Lorentz boost to frame where the collision is head-on
+  // phi is the half crossing angle in the plane ZS
+  // alpha is the angle to the S axis from the X axis in the XY plane
+
+  double calpha = std::cos(alpha);
+  double salpha = std::sin(alpha);
+  double cphi = std::cos(phi);
+  double sphi = std::sin(phi);
+  double tphi = sphi/cphi;
+  m_[0][0] = 1./cphi;
+  m_[0][1] = - calpha*sphi;
+  m_[0][2] = - tphi*sphi;
+  m_[0][3] = - salpha*sphi;
+  m_[1][0] = - calpha*tphi;
+  m_[1][1] = 1.;
+  m_[1][2] = calpha*tphi;
+  m_[1][3] = 0.;
+  m_[2][0] = 0.;
+  m_[2][1] = -calpha*sphi;
+  m_[2][2] = cphi;
+  m_[2][3] = - salpha*sphi;
+  m_[3][0] = - salpha*tphi;
+  m_[3][1] = 0.;
+  m_[3][2] = salpha*tphi;
+  m_[3][3] = 1.;
+
+}
+
+CrossingAngleBoost
+CrossingAngleBoost::inverse() const { 
+
+  // The 2x2 minors of the first two and of the last two rows
+  const double (*a)[4] = m_;
+  double s0 = a[0][0]*a[1][1] - a[1][0]*a[0][1];
+  double s1 = a[0][0]*a[1][2] - a[1][0]*a[0][2];
+  double s2 = a[0][0]*a[1][3] - a[1][0]*a[0][3];
+  double s3 = a[0][1]*a[1][2] - a[1][1]*a[0][2];
+  double s4 = a[0][1]*a[1][3] - a[1][1]*a[0][3];
+  double s5 = a[0][2]*a[1][3] - a[1][2]*a[0][3];
+  double c5 = a[2][2]*a[3][3] - a[3][2]*a[2][3];
+  double c4 = a[2][1]*a[3][3] - a[3][1]*a[2][3];
+  double c3 = a[2][1]*a[3][2] - a[3][1]*a[2][2];
+  double c2 = a[2][0]*a[3][3] - a[3][0]*a[2][3];
+  double c1 = a[2][0]*a[3][2] - a[3][0]*a[2][2];
+  double c0 = a[2][0]*a[3][1] - a[3][0]*a[2][1];
+  double det = s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+  double d = 1./det;
+
+  CrossingAngleBoost inv;
+  double (*b)[4] = inv.m_;
+  b[0][0] = ( a[1][1]*c5 - a[1][2]*c4 + a[1][3]*c3) * d;
+  b[0][1] = (-a[0][1]*c5 + a[0][2]*c4 - a[0][3]*c3) * d;
+  b[0][2] = ( a[3][1]*s5 - a[3][2]*s4 + a[3][3]*s3) * d;
+  b[0][3] = (-a[2][1]*s5 + a[2][2]*s4 - a[2][3]*s3) * d;
+  b[1][0] = (-a[1][0]*c5 + a[1][2]*c2 - a[1][3]*c1) * d;
+  b[1][1] = ( a[0][0]*c5 - a[0][2]*c2 + a[0][3]*c1) * d;
+  b[1][2] = (-a[3][0]*s5 + a[3][2]*s2 - a[3][3]*s1) * d;
+  b[1][3] = ( a[2][0]*s5 - a[2][2]*s2 + a[2][3]*s1) * d;
+  b[2][0] = ( a[1][0]*c4 - a[1][1]*c2 + a[1][3]*c0) * d;
+  b[2][1] = (-a[0][0]*c4 + a[0][1]*c2 - a[0][3]*c0) * d;
+  b[2][2] = ( a[3][0]*s4 - a[3][1]*s2 + a[3][3]*s0) * d;
+  b[2][3] = (-a[2][0]*s4 + a[2][1]*s2 - a[2][3]*s0) * d;
+  b[3][0] = (-a[1][0]*c3 + a[1][1]*c1 - a[1][2]*c0) * d;
+  b[3][1] = ( a[0][0]*c3 - a[0][1]*c1 + a[0][2]*c0) * d;
+  b[3][2] = (-a[3][0]*s3 + a[3][1]*s1 - a[3][2]*s0) * d;
+  b[3][3] = ( a[2][0]*s3 - a[2][1]*s1 + a[2][2]*s0) * d;
+  return inv;
+
+}
+
+void
+CrossingAngleBoost::apply(unsigned n, double* x, double* y, double* z, double* t) const { 
+
+  // The elements in local variables, so that the loop does not reload them
+  const double m00 = m_[0][0], m01 = m_[0][1], m02 = m_[0][2], m03 = m_[0][3];
+  const double m10 = m_[1][0], m11 = m_[1][1], m12 = m_[1][2], m13 = m_[1][3];
+  const double m20 = m_[2][0], m21 = m_[2][1], m22 = m_[2][2], m23 = m_[2][3];
+  const double m30 = m_[3][0], m31 = m_[3][1], m32 = m_[3][2], m33 = m_[3][3];
+  for ( unsigned i=0; i<n; ++i ) { 
+    double xi = x[i], yi = y[i], zi = z[i], ti = t[i];
+    x[i] = m00*xi + m01*yi + m02*zi + m03*ti;
+    y[i] = m10*xi + m11*yi + m12*zi + m13*ti;
+    z[i] = m20*xi + m21*yi + m22*zi + m23*ti;
+    t[i] = m30*xi + m31*yi + m32*zi + m33*ti;
+  }
+
+}
@@ -5,6 +5,7 @@
 
 //Framework Headers
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
 
 //CMSSW Data Formats
 #include "DataFormats/HepMCCandidate/interface/GenParticle.h"
@@ -15,20 +16,25 @@
 #include "FastSimulation/Event/interface/FSimTrack.h"
 #include "FastSimulation/Event/interface/FSimVertex.h"
 #include "FastSimulation/Event/interface/KineParticleFilter.h"
+#include "FastSimulation/Event/interface/FSimSurfaceGeometry.h"
 #include "FastSimulation/BaseParticlePropagator/interface/BaseParticlePropagator.h"
 #include "FastSimulation/Event/interface/BetaFuncPrimaryVertexGenerator.h"
+#include "FastSimulation/Event/interface/BetaFunc4DPrimaryVertexGenerator.h"
 #include "FastSimulation/Event/interface/GaussianPrimaryVertexGenerator.h"
 #include "FastSimulation/Event/interface/FlatPrimaryVertexGenerator.h"
 #include "FastSimulation/Event/interface/NoPrimaryVertexGenerator.h"
+#include "FastSimulation/Event/interface/TabulatedPrimaryVertexGenerator.h"
 
 #include "FastSimDataFormats/NuclearInteractions/interface/FSimVertexType.h"
 
+// TBB
+#include "tbb/parallel_for.h"
+
 using namespace HepPDT;
 
 // system include
 #include <iostream>
 #include <iomanip>
-#include <map>
 #include <string>
 
 FBaseSimEvent::FBaseSimEvent(const edm::ParameterSet& kine) 
@@ -37,32 +43,22 @@ FBaseSimEvent::FBaseSimEvent(const edm::ParameterSet& kine)
   nSimVertices(0),
   nGenParticles(0),
   nChargedParticleTracks(0),
-  initialSize(5000),
+  nBufferAllocations(0),
+  theParallelPropagation(false),
+  theTracksPerBlock(64),
+  theBatchPropagation(false),
+  theLazyPropagation(false),
   random(0)
 {
 
   theVertexGenerator = new NoPrimaryVertexGenerator();
   theBeamSpot = math::XYZPoint(0.0,0.0,0.0);
 
-  // Initialize the vectors of particles and vertices
-  theGenParticles = new std::vector<HepMC::GenParticle*>(); 
-  theSimTracks = new std::vector<FSimTrack>;
-  theSimVertices = new std::vector<FSimVertex>;
-  theChargedTracks = new std::vector<unsigned>();
-  theFSimVerticesType = new FSimVertexTypeCollection();
+  // Read the optional settings of the event
+  initializeOptions(kine);
 
-  // Reserve some size to avoid mutiple copies
-  /* */
-  theSimTracks->resize(initialSize);
-  theSimVertices->resize(initialSize);
-  theGenParticles->resize(initialSize);
-  theChargedTracks->resize(initialSize);
-  theFSimVerticesType->resize(initialSize);
-  theTrackSize = initialSize;
-  theVertexSize = initialSize;
-  theGenSize = initialSize;
-  theChargedSize = initialSize;
-  /* */
+  // Initialize the vectors of particles and vertices
+  initializeBuffers();
 
   // Initialize the Particle filter
   myFilter = new KineParticleFilter(kine);
@@ -77,7 +73,11 @@ FBaseSimEvent::FBaseSimEvent(const edm::ParameterSet& vtx,
   nSimVertices(0),
   nGenParticles(0),
   nChargedParticleTracks(0), 
-  initialSize(5000),
+  nBufferAllocations(0),
+  theParallelPropagation(false),
+  theTracksPerBlock(64),
+  theBatchPropagation(false),
+  theLazyPropagation(false),
   theVertexGenerator(0), 
   random(engine)
 {
@@ -90,8 +90,15 @@ FBaseSimEvent::FBaseSimEvent(const edm::ParameterSet& vtx,
     theVertexGenerator = new FlatPrimaryVertexGenerator(vtx,random);
   else if ( vtxType == "BetaFunc" )
     theVertexGenerator = new BetaFuncPrimaryVertexGenerator(vtx,random);
+  else if ( vtxType == "BetaFunc4D" )
+    theVertexGenerator = new BetaFunc4DPrimaryVertexGenerator(vtx,random);
+  else if ( vtxType == "Tabulated" )
+    theVertexGenerator = new TabulatedPrimaryVertexGenerator(vtx,random);
   else
     theVertexGenerator = new NoPrimaryVertexGenerator();
+  // Reproducible vertices, whatever the order of the calls (optional)
+  if ( vtx.exists("counterBasedSeed") )
+    theVertexGenerator->setCounterBasedSeed(vtx.getParameter<unsigned>("counterBasedSeed"));
   // Initialize the beam spot, if not read from the DataBase
   theBeamSpot = math::XYZPoint(0.0,0.0,0.0);
 
@@ -100,31 +107,201 @@ FBaseSimEvent::FBaseSimEvent(const edm::ParameterSet& vtx,
   // unit : cm x cm
   lateVertexPosition = 2.5*2.5;
 
+  // Read the optional settings of the event
+  initializeOptions(kine);
+
   // Initialize the vectors of particles and vertices
+  initializeBuffers();
+
+  // Initialize the Particle filter
+  myFilter = new KineParticleFilter(kine);
+
+}
+ 
+void
+FBaseSimEvent::initializeOptions(const edm::ParameterSet& kine) {
+
+  // The sizing of the event buffers
+  if ( kine.exists("CapacityPolicy") ) {
+    theTrackCapacity = 
+      FSimEventCapacityPolicy(kine.getUntrackedParameter<edm::ParameterSet>("CapacityPolicy"));
+    theVertexCapacity = theTrackCapacity;
+  }
+
+  // The propagation to the calorimeters : surfaces, particles and field
+  if ( kine.exists("PropagationPlan") ) 
+    thePropagationPlan = 
+      FSimPropagationPlan(kine.getParameter<edm::ParameterSet>("PropagationPlan"));
+
+  // The propagation to the calorimeters, in parallel or not
+  setParallelPropagation(kine.getUntrackedParameter<bool>("parallelPropagation",false),
+			 kine.getUntrackedParameter<unsigned>("tracksPerBlock",64));
+
+  // The propagation to the calorimeters, with the batch propagator or not
+  setBatchPropagation(kine.getUntrackedParameter<bool>("batchPropagation",false));
+
+  // The propagation to the calorimeters, only when needed
+  setLazyPropagation(kine.getUntrackedParameter<bool>("lazyPropagation",false));
+
+}
+
+void
+FBaseSimEvent::initializeBuffers() {
+
   theGenParticles = new std::vector<HepMC::GenParticle*>(); 
   theSimTracks = new std::vector<FSimTrack>;
+  theTrackColumns = new FSimTrackColumns();
+  theSurfaceTable = new FSimSurfaceTable();
+  theGenRecord = new FSimGenRecord();
+  theTrackIdTable = new FSimTrackIdTable();
+  theVertexDaughters = new FSimDaughterTable();
+  theTrackDaughters = new FSimDaughterTable();
   theSimVertices = new std::vector<FSimVertex>;
   theChargedTracks = new std::vector<unsigned>();
   theFSimVerticesType = new FSimVertexTypeCollection();
 
-  // Reserve some size to avoid mutiple copies
-  /* */
-  theSimTracks->resize(initialSize);
-  theSimVertices->resize(initialSize);
-  theGenParticles->resize(initialSize);
-  theChargedTracks->resize(initialSize);
-  theFSimVerticesType->resize(initialSize);
-  theTrackSize = initialSize;
-  theVertexSize = initialSize;
-  theGenSize = initialSize;
-  theChargedSize = initialSize;
-  /* */
+  // The objects returned for out-of-range indices
+  theInvalidTrack = new FSimTrack();
+  theInvalidVertex = new FSimVertex();
+  theInvalidVertexType = new FSimVertexType();
+
+  // The batch propagators (one per thread, created when first used)
+  theBatchPropagators = 
+    new tbb::enumerable_thread_specific<FSimBatchPropagator>(FSimBatchPropagator(thePropagationPlan.bField()));
+
+  // Reserve some size to avoid mutiple copies. 
+  // Nothing is constructed until the event is filled.
+  unsigned nTracks = theTrackCapacity.initialSize();
+  unsigned nVertices = theVertexCapacity.initialSize();
+  theSimTracks->reserve(nTracks);
+  theTrackColumns->reserve(nTracks);
+  theGenParticles->reserve(nTracks);
+  theChargedTracks->reserve(nTracks);
+  theSimVertices->reserve(nVertices);
+  theFSimVerticesType->reserve(nVertices);
 
-  // Initialize the Particle filter
-  myFilter = new KineParticleFilter(kine);
+}
+
+void
+FBaseSimEvent::setCapacityPolicy(const FSimEventCapacityPolicy& policy) {
+
+  clear();
+  theTrackCapacity = policy;
+  theVertexCapacity = policy;
+  releaseBuffers(theTrackCapacity.initialSize(),theVertexCapacity.initialSize());
 
 }
- 
+
+// Release the memory of a vector, and make room for n elements.
+// Return the number of reallocations (0 or 1).
+template <class T> static unsigned 
+release(std::vector<T>& v, unsigned n) { 
+  std::vector<T>().swap(v);
+  v.reserve(n);
+  return n ? 1 : 0;
+}
+
+// The memory taken by a vector
+template <class T> static unsigned long 
+memory(const std::vector<T>& v) { 
+  return v.capacity()*sizeof(T);
+}
+
+void
+FBaseSimEvent::releaseBuffers(unsigned nTracks, unsigned nVertices) {
+
+  // The buffers are allocated anew (the tables count their own 
+  // reallocations, and the others will be counted as they grow again)
+
+  // Track-sized buffers
+  nBufferAllocations += release(*theSimTracks,nTracks);
+  nBufferAllocations += release(*theGenParticles,nTracks);
+  nBufferAllocations += release(*theChargedTracks,nTracks);
+  release(theSimTrackIndex,0);
+  release(theGenVertexIndex,0);
+  theTrackColumns->release(nTracks);
+  theSurfaceTable->release();
+  theGenRecord->release();
+  theTrackIdTable->release();
+  theTrackDaughters->release();
+
+  // Vertex-sized buffers
+  nBufferAllocations += release(*theSimVertices,nVertices);
+  nBufferAllocations += release(*theFSimVerticesType,nVertices);
+  release(theSimVertexIndex,0);
+  release(theSimVertexMother,0);
+  theVertexDaughters->release();
+
+  // Propagation blocks
+  std::vector< std::vector<FSimSurfaceTable::Hit> >().swap(theSurfaceHits);
+  release(theSurfaceHitRoom,0);
+  release(theLazyLevel,0);
+  release(theLazyStates,0);
+  release(theLazyHits,0);
+
+}
+
+void
+FBaseSimEvent::adaptCapacity() {
+
+  // Nothing was filled since the last call
+  if ( !nSimVertices ) return;
+
+  theTrackCapacity.record(nSimTracks);
+  theVertexCapacity.record(nSimVertices);
+  unsigned nTracks = theTrackCapacity.target();
+  unsigned nVertices = theVertexCapacity.target();
+
+  // Release the memory taken by an outlier event, once enough normal 
+  // events have been seen
+  if ( theTrackCapacity.release(theSimTracks->capacity()) || 
+       theVertexCapacity.release(theSimVertices->capacity()) ) {
+    releaseBuffers(nTracks,nVertices);
+    return;
+  }
+
+  // Otherwise make room for the typical events
+  if ( nTracks > theSimTracks->capacity() ) { 
+    ++nBufferAllocations;
+    theSimTracks->reserve(nTracks);
+  }
+  theTrackColumns->reserve(nTracks);
+  if ( nVertices > theSimVertices->capacity() ) { 
+    ++nBufferAllocations;
+    theSimVertices->reserve(nVertices);
+  }
+  if ( nVertices > theFSimVerticesType->capacity() ) { 
+    ++nBufferAllocations;
+    theFSimVerticesType->reserve(nVertices);
+  }
+
+}
+
+unsigned long
+FBaseSimEvent::memoryFootprint() const {
+  unsigned long hits = 0;
+  for ( unsigned ib=0; ib<theSurfaceHits.size(); ++ib ) 
+    hits += memory(theSurfaceHits[ib]);
+  tbb::enumerable_thread_specific<FSimBatchPropagator>::const_iterator batch;
+  for ( batch=theBatchPropagators->begin(); batch!=theBatchPropagators->end(); ++batch ) 
+    hits += batch->memory();
+  return hits +
+    memory(*theSimTracks) + memory(*theSimVertices) + 
+    memory(*theFSimVerticesType) + memory(*theGenParticles) + 
+    memory(*theChargedTracks) + memory(theSimVertexIndex) + memory(theSimVertexMother) +
+    memory(theSimTrackIndex) + memory(theGenVertexIndex) +
+    theTrackColumns->memory() + theSurfaceTable->memory() + theGenRecord->memory() +
+    theTrackIdTable->memory() +
+    theVertexDaughters->memory() + theTrackDaughters->memory() +
+    memory(theSurfaceHits) + memory(theSurfaceHitRoom) +
+    memory(theLazyLevel) + memory(theLazyStates) + memory(theLazyHits);
+}
+
+void
+FBaseSimEvent::endJob() const {
+  myFilter->endJob();
+}
+
 FBaseSimEvent::~FBaseSimEvent(){
 
   // Clear the vectors
@@ -137,9 +314,19 @@ FBaseSimEvent::~FBaseSimEvent(){
   // Delete 
   delete theGenParticles;
   delete theSimTracks;
+  delete theTrackColumns;
+  delete theSurfaceTable;
+  delete theGenRecord;
+  delete theTrackIdTable;
+  delete theVertexDaughters;
+  delete theTrackDaughters;
   delete theSimVertices;
   delete theChargedTracks;
   delete theFSimVerticesType;
+  delete theInvalidTrack;
+  delete theInvalidVertex;
+  delete theInvalidVertexType;
+  delete theBatchPropagators;
   delete myFilter;
 
 }
@@ -147,7 +334,21 @@ FBaseSimEvent::~FBaseSimEvent(){
 void 
 FBaseSimEvent::initializePdt(const HepPDT::ParticleDataTable* aPdt) { 
 
+  // Made again for each table given, as it points to the table content
+  initializePdt(aPdt,std::make_shared<const FSimParticleProperties>(*aPdt,*myFilter));
+
+}
+
+void 
+FBaseSimEvent::initializePdt(const HepPDT::ParticleDataTable* aPdt,
+			     const std::shared_ptr<const FSimParticleProperties>& properties) { 
+
+  if ( !properties || properties->table() != aPdt ) 
+    throw cms::Exception("FBaseSimEvent") 
+      << "The particle properties were not made from the particle data table\n";
+
   pdt = aPdt; 
+  theParticleProperties = properties;
 
 }
 
@@ -167,6 +368,10 @@ FBaseSimEvent::fill(const HepMC::GenEvent& myGenEvent) {
   // Add the particles in the FSimEvent
   addParticles(myGenEvent);
 
+  // Compact the decay tree
+  theVertexDaughters->finalize();
+  theTrackDaughters->finalize();
+
   /*
   std::cout << "The MC truth! " << std::endl;
   printMCTruth(myGenEvent);
@@ -186,6 +391,10 @@ FBaseSimEvent::fill(const reco::GenParticleCollection& myGenParticles) {
   // Add the particles in the FSimEvent
   addParticles(myGenParticles);
 
+  // Compact the decay tree
+  theVertexDaughters->finalize();
+  theTrackDaughters->finalize();
+
 }
 
 void
@@ -204,24 +413,19 @@ FBaseSimEvent::fill(const std::vector<SimTrack>& simTracks,
   if ( nVtx == 0 ) return;
 
   // Two arrays for internal use.
-  std::vector<int> myVertices(nVtx,-1);
-  std::vector<int> myTracks(nTks,-1);
-
-  // create a map associating geant particle id and position in the 
-  // event SimTrack vector
-  
-  std::map<unsigned, unsigned> geantToIndex;
-  for( unsigned it=0; it<simTracks.size(); ++it ) {
-    geantToIndex[ simTracks[it].trackId() ] = it;
-  }  
-
-  // Create also a map associating a SimTrack with its endVertex
-  /*
-  std::map<unsigned, unsigned> endVertex;
-  for ( unsigned iv=0; iv<simVertices.size(); ++iv ) { 
-    endVertex[ simVertices[iv].parentIndex() ] = iv;
-  }
-  */
+  assign(theSimVertexIndex, nVtx, -1);
+  assign(theSimTrackIndex, nTks, -1);
+  std::vector<int>& myVertices = theSimVertexIndex;
+  std::vector<int>& myTracks = theSimTrackIndex;
+
+  // Associate the geant track ids with their positions in the event 
+  // SimTrack vector, and find the mother track of each vertex, once
+  theTrackIdTable->fill(simTracks);
+  assign(theSimVertexMother, nVtx, -1);
+  std::vector<int>& myMothers = theSimVertexMother;
+  for ( unsigned iv=0; iv<nVtx; ++iv ) 
+    if ( !simVertices[iv].noParent() ) // there is a parent to this vertex
+      myMothers[iv] = theTrackIdTable->find(simVertices[iv].parentIndex());
 
   // Set the main vertex for the kine particle filter
   // SimVertices were in mm until 110_pre2
@@ -252,15 +456,7 @@ FBaseSimEvent::fill(const std::vector<SimTrack>& simTracks,
     //std::cout << "Origin vertex " << vertexId << " " << vertex << std::endl;
 
     // The mother track 
-    int motherId = -1;
-    if( !vertex.noParent() ) { // there is a parent to this vertex
-      // geant id of the mother
-      unsigned motherGeantId =   vertex.parentIndex(); 
-      std::map<unsigned, unsigned >::iterator association  
-	= geantToIndex.find( motherGeantId );
-      if(association != geantToIndex.end() )
-	motherId = association->second;
-    }
+    int motherId = myMothers[vertexId];
     int originId = motherId == - 1 ? -1 : myTracks[motherId];
     //std::cout << "Origin id " << originId << std::endl;
 
@@ -330,16 +526,7 @@ FBaseSimEvent::fill(const std::vector<SimTrack>& simTracks,
     const SimVertex& vertex = simVertices[vertexId];
 
     // The mother track 
-    int motherId = -1;
-    if( !vertex.noParent() ) { // there is a parent to this vertex
-
-      // geant id of the mother
-      unsigned motherGeantId =   vertex.parentIndex(); 
-      std::map<unsigned, unsigned >::iterator association  
-	= geantToIndex.find( motherGeantId );
-      if(association != geantToIndex.end() )
-	motherId = association->second;
-    }
+    int motherId = myMothers[vertexId];
     int originId = motherId == - 1 ? -1 : myTracks[motherId];
 
     // Add the vertex
@@ -352,89 +539,334 @@ FBaseSimEvent::fill(const std::vector<SimTrack>& simTracks,
     myVertices[vertexId] = addSimVertex(position,originId); 
   }
 
-  // Finally, propagate all particles to the calorimeters
+  // Compact the decay tree
+  theVertexDaughters->finalize();
+  theTrackDaughters->finalize();
+
+  // Finally, propagate all particles to the calorimeters - or 
+  // remember that nothing is propagated yet
+  if ( theLazyPropagation ) { 
+    assign(theLazyLevel,nSimTracks,-1);
+    // The states are written before they are read: only grow the array
+    if ( nSimTracks > theLazyStates.size() ) { 
+      if ( nSimTracks > theLazyStates.capacity() ) ++nBufferAllocations;
+      theLazyStates.resize(nSimTracks);
+    }
+  } else { 
+    propagateToCalorimeters();
+  }
+
+}
+
+void
+FBaseSimEvent::setParallelPropagation(bool parallel, unsigned tracksPerBlock) {
+  theParallelPropagation = parallel;
+  theTracksPerBlock = tracksPerBlock ? tracksPerBlock : 1;
+}
+
+void
+FBaseSimEvent::setBatchPropagation(bool batch) {
+  theBatchPropagation = batch;
+}
+
+void
+FBaseSimEvent::setPropagationPlan(const FSimPropagationPlan& plan) {
+
+  thePropagationPlan = plan;
+
+  // The batch propagators, in the field of the plan
+  delete theBatchPropagators;
+  theBatchPropagators = 
+    new tbb::enumerable_thread_specific<FSimBatchPropagator>(FSimBatchPropagator(plan.bField()));
+
+}
+
+void
+FBaseSimEvent::setLazyPropagation(bool lazy) {
+  theLazyPropagation = lazy;
+}
+
+void
+FBaseSimEvent::materialize(FSimSurfaceTable::Surface s) {
+
+  // Nothing pending (eager propagation)
+  if ( theLazyLevel.empty() ) return;
+
+  // By blocks, as in the eager propagation
+  propagateToCalorimeters(s);
+
+}
+
+void
+FBaseSimEvent::materialize(int id, FSimSurfaceTable::Surface s) {
+
+  if ( (unsigned)id >= theLazyLevel.size() ) return;
+
+  theLazyHits.clear();
+  propagateLazily(id,s,theLazyHits);
+  for ( unsigned ih=0; ih<theLazyHits.size(); ++ih ) 
+    track(id).setSurface(theLazyHits[ih].surface,theLazyHits[ih].state,theLazyHits[ih].success);
+
+}
+
+void
+FBaseSimEvent::materializeAll() {
+  materialize(FSimSurfaceTable::HO);
+}
+
+void
+FBaseSimEvent::propagateLazily(int id, FSimSurfaceTable::Surface s,
+			       std::vector<FSimSurfaceTable::Hit>& hits) {
+
+  // Beyond the HCAL entrance, the surfaces to which the track is 
+  // propagated depend on its state there: they are computed together
+  if ( s > FSimSurfaceTable::HCAL ) s = FSimSurfaceTable::HO;
+  int level = theLazyLevel[id];
+  if ( level >= s ) return;
+
+  // Continue from the last surface reached
   BaseParticlePropagator myPart;
-  XYZTLorentzVector mom;
-  XYZTLorentzVector pos;
+  if ( level >= 0 ) 
+    myPart = BaseParticlePropagator(theLazyStates[id],0.,0.,thePropagationPlan.bField());
+  propagateTrack(id,myPart,hits,(FSimSurfaceTable::Surface)(level+1),s);
+  theLazyStates[id] = myPart;
+  theLazyLevel[id] = s;
 
+}
 
-  // Loop over the tracks
-  for( int fsimi=0; fsimi < (int)nTracks() ; ++fsimi) {
+void
+FBaseSimEvent::propagateToCalorimeters(FSimSurfaceTable::Surface last) {
+
+  // The tracks are independent from each other: they are propagated by
+  // blocks, each block keeping the states found aside. The states are 
+  // then stored in the track order, whatever the order in which the 
+  // blocks were processed.
+  unsigned nBlocks = (nSimTracks+theTracksPerBlock-1)/theTracksPerBlock;
+  if ( nBlocks > theSurfaceHits.capacity() ) ++nBufferAllocations;
+  if ( nBlocks > theSurfaceHits.size() ) theSurfaceHits.resize(nBlocks);
+  if ( nBlocks > theSurfaceHitRoom.capacity() ) ++nBufferAllocations;
+  theSurfaceHitRoom.resize(nBlocks);
+  for ( unsigned ib=0; ib<nBlocks; ++ib ) { 
+    theSurfaceHits[ib].clear();
+    theSurfaceHitRoom[ib] = theSurfaceHits[ib].capacity();
+  }
 
-    
-    FSimTrack& myTrack = track(fsimi);
-    double trackerSurfaceTime = myTrack.vertex().position().t() 
-                              + myTrack.momentum().e()/myTrack.momentum().pz()
-                              * ( myTrack.trackerSurfacePosition().z()
-				- myTrack.vertex().position().z() );
-    pos = XYZTLorentzVector(myTrack.trackerSurfacePosition().x(),
-			    myTrack.trackerSurfacePosition().y(),
-			    myTrack.trackerSurfacePosition().z(),
-			            trackerSurfaceTime);
-    mom = XYZTLorentzVector(myTrack.trackerSurfaceMomentum().x(),
-			    myTrack.trackerSurfaceMomentum().y(),
-			    myTrack.trackerSurfaceMomentum().z(),
-			    myTrack.trackerSurfaceMomentum().t());
-
-    if ( mom.T() >  0. ) {  
-      // The particle to be propagated
-      myPart = BaseParticlePropagator(RawParticle(mom,pos),0.,0.,4.);
-      myPart.setCharge(myTrack.charge());
-      
-      // Propagate to Preshower layer 1
-      myPart.propagateToPreshowerLayer1(false);
-      if ( myTrack.notYetToEndVertex(myPart.vertex()) && myPart.getSuccess()>0 )
-	myTrack.setLayer1(myPart,myPart.getSuccess());
-      
-      // Propagate to Preshower Layer 2 
-      myPart.propagateToPreshowerLayer2(false);
-      if ( myTrack.notYetToEndVertex(myPart.vertex()) && myPart.getSuccess()>0 )
-	myTrack.setLayer2(myPart,myPart.getSuccess());
-      
-      // Propagate to Ecal Endcap
-      myPart.propagateToEcalEntrance(false);
-      if ( myTrack.notYetToEndVertex(myPart.vertex()) )
-	myTrack.setEcal(myPart,myPart.getSuccess());
-      
-      // Propagate to HCAL entrance
-      myPart.propagateToHcalEntrance(false);
-      if ( myTrack.notYetToEndVertex(myPart.vertex()) )
-	myTrack.setHcal(myPart,myPart.getSuccess());
-      
-      // Attempt propagation to HF for low pt and high eta 
-      if ( myPart.cos2ThetaV()>0.8 || mom.T() < 3. ) {
-	// Propagate to VFCAL entrance
-	myPart.propagateToVFcalEntrance(false);
-	if ( myTrack.notYetToEndVertex(myPart.vertex()) )
- 	myTrack.setVFcal(myPart,myPart.getSuccess());
-	
-	// Otherwise propagate to the HCAL exit and HO.
-      } else { 
-	// Propagate to HCAL exit
-	myPart.propagateToHcalExit(false);
-	if ( myTrack.notYetToEndVertex(myPart.vertex()) )
-	  myTrack.setHcalExit(myPart,myPart.getSuccess());     
-	// Propagate to HOLayer entrance
-	myPart.setMagneticField(0);
-	myPart.propagateToHOLayer(false);
-	if ( myTrack.notYetToEndVertex(myPart.vertex()) )
-	  myTrack.setHO(myPart,myPart.getSuccess());
-      } 
+  // Propagate
+  if ( theParallelPropagation && nBlocks > 1 ) 
+    tbb::parallel_for(0U, nBlocks, [this,last](unsigned ib) { propagateBlock(ib,last); });
+  else
+    for ( unsigned ib=0; ib<nBlocks; ++ib ) propagateBlock(ib,last);
+
+  // Store the states found, in the track order
+  for ( unsigned ib=0; ib<nBlocks; ++ib ) { 
+    const std::vector<FSimSurfaceTable::Hit>& hits = theSurfaceHits[ib];
+    if ( hits.capacity() > theSurfaceHitRoom[ib] ) ++nBufferAllocations;
+    for ( unsigned ih=0; ih<hits.size(); ++ih ) 
+      track(hits[ih].track).setSurface(hits[ih].surface,hits[ih].state,hits[ih].success);
+  }
+
+}
+
+void
+FBaseSimEvent::propagateBlock(unsigned block, FSimSurfaceTable::Surface surface) {
+
+  std::vector<FSimSurfaceTable::Hit>& hits = theSurfaceHits[block];
+  int first = block*theTracksPerBlock;
+  int last = first+theTracksPerBlock < nSimTracks ? 
+    first+theTracksPerBlock : nSimTracks;
+
+  // Lazy propagation : each track continues from the last surface reached
+  if ( !theLazyLevel.empty() ) { 
+    for( int fsimi=first; fsimi < last ; ++fsimi) 
+      propagateLazily(fsimi,surface,hits);
+    return;
+  }
+
+  // The batch propagator of the thread
+  if ( theBatchPropagation ) { 
+    propagateBatch(first,last,theBatchPropagators->local(),hits);
+    return;
+  }
+
+  // One propagator per block (hence per thread)
+  BaseParticlePropagator myPart;
+  for( int fsimi=first; fsimi < last ; ++fsimi) 
+    propagateTrack(fsimi,myPart,hits);
+
+}
+
+void
+FBaseSimEvent::propagateBatch(int first, int last, FSimBatchPropagator& batch,
+			      std::vector<FSimSurfaceTable::Hit>& hits) const {
+
+  // The particles at the tracker surface, and the surfaces needed by 
+  // at least one of them according to the plan
+  batch.clear();
+  unsigned steps = 0;
+  for( int fsimi=first; fsimi < last ; ++fsimi) {
+    const FSimTrack& myTrack = track(fsimi);
+    XYZTLorentzVector pos, mom;
+    trackerSurfaceState(myTrack,pos,mom);
+    if ( mom.T() <= 0. ) continue;
+    unsigned store = thePropagationPlan.surfaces(myTrack.type(),mom.Pt(),mom.T());
+    if ( !store ) continue;
+    steps |= FSimPropagationPlan::steps(store);
+    batch.add(pos,mom,myTrack.charge());
+  }
+  if ( !batch.size() ) return;
+
+  // Propagate them all at once, to these surfaces only
+  batch.propagate(steps);
+
+  // Keep the states found, as in propagateTrack
+  unsigned i = 0;
+  for( int fsimi=first; fsimi < last ; ++fsimi) {
+    const FSimTrack& myTrack = track(fsimi);
+    const XYZTLorentzVector& mom = myTrack.trackerSurfaceMomentum();
+    if ( mom.t() <= 0. ) continue;
+    unsigned store = thePropagationPlan.surfaces(myTrack.type(),mom.Pt(),mom.t());
+    if ( !store ) continue;
+    for ( unsigned s=0; s<FSimSurfaceTable::NSURFACES; ++s ) { 
+      FSimSurfaceTable::Surface surface = (FSimSurfaceTable::Surface)s;
+      if ( !( store & FSimPropagationPlan::bit(surface) ) ) continue;
+      if ( !batch.computed(i,surface) ) continue;
+      int success = batch.success(i,surface);
+      // Only the preshower layers actually reached are kept
+      if ( ( surface == FSimSurfaceTable::LAYER1 || 
+	     surface == FSimSurfaceTable::LAYER2 ) && success <= 0 ) continue;
+      RawParticle state = batch.state(i,surface);
+      if ( myTrack.notYetToEndVertex(state.vertex()) )
+	hits.push_back(FSimSurfaceTable::Hit(fsimi,surface,state,success));
     }
+    ++i;
   }
+
 }
 
+void
+FBaseSimEvent::trackerSurfaceState(const FSimTrack& myTrack,
+				   XYZTLorentzVector& pos,
+				   XYZTLorentzVector& mom) const {
+
+  double trackerSurfaceTime = myTrack.vertex().position().t() 
+                            + myTrack.momentum().e()/myTrack.momentum().pz()
+                            * ( myTrack.trackerSurfacePosition().z()
+			      - myTrack.vertex().position().z() );
+  pos = XYZTLorentzVector(myTrack.trackerSurfacePosition().x(),
+			  myTrack.trackerSurfacePosition().y(),
+			  myTrack.trackerSurfacePosition().z(),
+			  trackerSurfaceTime);
+  mom = XYZTLorentzVector(myTrack.trackerSurfaceMomentum().x(),
+			  myTrack.trackerSurfaceMomentum().y(),
+			  myTrack.trackerSurfaceMomentum().z(),
+			  myTrack.trackerSurfaceMomentum().t());
+
+}
 
 void
-FBaseSimEvent::addParticles(const HepMC::GenEvent& myGenEvent) {
+FBaseSimEvent::propagateTrack(int fsimi, BaseParticlePropagator& myPart,
+			      std::vector<FSimSurfaceTable::Hit>& hits,
+			      FSimSurfaceTable::Surface first,
+			      FSimSurfaceTable::Surface last) const {
+
+  const FSimTrack& myTrack = track(fsimi);
+  XYZTLorentzVector pos, mom;
+  trackerSurfaceState(myTrack,pos,mom);
+
+  if ( mom.T() <= 0. ) return;
+
+  // The surfaces on which the particle state is kept, and those to 
+  // which the particle must be propagated, according to the plan
+  unsigned store = thePropagationPlan.surfaces(myTrack.type(),mom.Pt(),mom.T());
+  unsigned steps = FSimPropagationPlan::steps(store);
+  if ( !steps ) return;
+
+  // The particle to be propagated, unless already on its way
+  if ( first == FSimSurfaceTable::LAYER1 ) { 
+    myPart = BaseParticlePropagator(RawParticle(mom,pos),0.,0.,thePropagationPlan.bField());
+    myPart.setCharge(myTrack.charge());
+  }
+    
+  // Propagate to Preshower layer 1
+  if ( first <= FSimSurfaceTable::LAYER1 && 
+       ( steps & FSimPropagationPlan::bit(FSimSurfaceTable::LAYER1) ) ) { 
+    myPart.propagateToPreshowerLayer1(false);
+    if ( myTrack.notYetToEndVertex(myPart.vertex()) && myPart.getSuccess()>0 )
+      hits.push_back(FSimSurfaceTable::Hit(fsimi,FSimSurfaceTable::LAYER1,myPart,myPart.getSuccess()));
+  }
+  if ( last < FSimSurfaceTable::LAYER2 ) return;
+
+  // Propagate to Preshower Layer 2 
+  if ( first <= FSimSurfaceTable::LAYER2 && 
+       ( steps & FSimPropagationPlan::bit(FSimSurfaceTable::LAYER2) ) ) { 
+    myPart.propagateToPreshowerLayer2(false);
+    if ( myTrack.notYetToEndVertex(myPart.vertex()) && myPart.getSuccess()>0 )
+      hits.push_back(FSimSurfaceTable::Hit(fsimi,FSimSurfaceTable::LAYER2,myPart,myPart.getSuccess()));
+  }
+  if ( last < FSimSurfaceTable::ECAL ) return;
+
+  // Propagate to Ecal Endcap
+  if ( first <= FSimSurfaceTable::ECAL && 
+       ( steps & FSimPropagationPlan::bit(FSimSurfaceTable::ECAL) ) ) { 
+    myPart.propagateToEcalEntrance(false);
+    if ( myTrack.notYetToEndVertex(myPart.vertex()) )
+      hits.push_back(FSimSurfaceTable::Hit(fsimi,FSimSurfaceTable::ECAL,myPart,myPart.getSuccess()));
+  }
+  if ( last < FSimSurfaceTable::HCAL ) return;
+
+  // Propagate to HCAL entrance (needed for all the surfaces beyond)
+  if ( !( steps & FSimPropagationPlan::bit(FSimSurfaceTable::HCAL) ) ) return;
+  if ( first <= FSimSurfaceTable::HCAL ) { 
+    myPart.propagateToHcalEntrance(false);
+    if ( ( store & FSimPropagationPlan::bit(FSimSurfaceTable::HCAL) ) && 
+	 myTrack.notYetToEndVertex(myPart.vertex()) )
+      hits.push_back(FSimSurfaceTable::Hit(fsimi,FSimSurfaceTable::HCAL,myPart,myPart.getSuccess()));
+  }
+  if ( last < FSimSurfaceTable::VFCAL ) return;
+
+  // Attempt propagation to HF for low pt and high eta 
+  if ( myPart.cos2ThetaV() > FSimSurfaceGeometry::vfcalCos2Theta || 
+       mom.T() < FSimSurfaceGeometry::vfcalEMax ) {
+    // Propagate to VFCAL entrance
+    if ( !( steps & FSimPropagationPlan::bit(FSimSurfaceTable::VFCAL) ) ) return;
+    myPart.propagateToVFcalEntrance(false);
+    if ( myTrack.notYetToEndVertex(myPart.vertex()) )
+      hits.push_back(FSimSurfaceTable::Hit(fsimi,FSimSurfaceTable::VFCAL,myPart,myPart.getSuccess()));
+      
+  // Otherwise propagate to the HCAL exit and HO.
+  } else { 
+    if ( last < FSimSurfaceTable::HCALEXIT ) return;
+    // Propagate to HCAL exit
+    if ( !( steps & FSimPropagationPlan::bit(FSimSurfaceTable::HCALEXIT) ) ) return;
+    myPart.propagateToHcalExit(false);
+    if ( ( store & FSimPropagationPlan::bit(FSimSurfaceTable::HCALEXIT) ) && 
+	 myTrack.notYetToEndVertex(myPart.vertex()) )
+      hits.push_back(FSimSurfaceTable::Hit(fsimi,FSimSurfaceTable::HCALEXIT,myPart,myPart.getSuccess()));
+    if ( last < FSimSurfaceTable::HO ) return;
+    // Propagate to HOLayer entrance
+    if ( !( steps & FSimPropagationPlan::bit(FSimSurfaceTable::HO) ) ) return;
+    myPart.setMagneticField(0);
+    myPart.propagateToHOLayer(false);
+    if ( myTrack.notYetToEndVertex(myPart.vertex()) )
+      hits.push_back(FSimSurfaceTable::Hit(fsimi,FSimSurfaceTable::HO,myPart,myPart.getSuccess()));
+  } 
 
-  /// Some internal array to work with.
-  int genEventSize = myGenEvent.particles_size();
-  std::vector<int> myGenVertices(genEventSize, static_cast<int>(0));
+}
+
+void
+FBaseSimEvent::addParticles(const HepMC::GenEvent& myGenEvent) {
 
   // If no particles, no work to be done !
   if ( myGenEvent.particles_empty() ) return;
 
+  // A flat copy of the particles, with their vertices and mothers
+  theGenRecord->fill(myGenEvent);
+
+  /// Some internal array to work with.
+  int genEventSize = theGenRecord->size();
+  assign(theGenVertexIndex, genEventSize, 0);
+  std::vector<int>& myGenVertices = theGenVertexIndex;
+
   // Are there particles in the FSimEvent already ? 
   int offset = nGenParts();
 
@@ -444,7 +876,7 @@ FBaseSimEvent::addParticles(const HepMC::GenEvent& myGenEvent) {
   // Beginning of workaround a bug in pythia particle gun
   unsigned primaryMother = primaryVertex->particles_in_size();
   if ( primaryMother ) {
-    unsigned partId = (*(primaryVertex->particles_in_const_begin()))->pdg_id();
+    int partId = (*(primaryVertex->particles_in_const_begin()))->pdg_id();
     if ( abs(partId) == 2212 ) primaryMother = 0;
   }
   // End of workaround a bug in pythia particle gun
@@ -466,7 +898,7 @@ FBaseSimEvent::addParticles(const HepMC::GenEvent& myGenEvent) {
       theVertexGenerator->X()-theVertexGenerator->beamSpot().X()+theBeamSpot.X(),
       theVertexGenerator->Y()-theVertexGenerator->beamSpot().Y()+theBeamSpot.Y(),
       theVertexGenerator->Z()-theVertexGenerator->beamSpot().Z()+theBeamSpot.Z(),
-      0.);
+      theVertexGenerator->time());
   }
 
   // Set the main vertex
@@ -475,162 +907,65 @@ FBaseSimEvent::addParticles(const HepMC::GenEvent& myGenEvent) {
   // This is the smeared main vertex
   int mainVertex = addSimVertex(myFilter->vertex(), -1, FSimVertexType::PRIMARY_VERTEX);
 
-  HepMC::GenEvent::particle_const_iterator piter;
-  HepMC::GenEvent::particle_const_iterator pbegin = myGenEvent.particles_begin();
-  HepMC::GenEvent::particle_const_iterator pend = myGenEvent.particles_end();
+  // Select the particles to be simulated: stable particles, particles 
+  // with stable daughters, and particles that fly more than one micron
+  theGenRecord->classify(primaryVertexPosition,smearedVertex,lateVertexPosition);
 
-  int initialBarcode = 0; 
-  if ( pbegin != pend ) initialBarcode = (*pbegin)->barcode();
-  // Loop on the particles of the generated event
-  for ( piter = pbegin; piter != pend; ++piter ) {
+  // Loop on the particles of the generated event, flattened once
+  const FSimGenRecord& gen = *theGenRecord;
+  for ( int ip = 0; ip < genEventSize; ++ip ) {
 
     // This is the generated particle pointer - for the signal event only
-    HepMC::GenParticle* p = *piter;
-
     if  ( !offset ) {
-      (*theGenParticles)[nGenParticles++] = p;
-      if ( nGenParticles/theGenSize*theGenSize == nGenParticles ) { 
-	theGenSize *= 2;
-	theGenParticles->resize(theGenSize);
-      }
-
+      if ( theGenParticles->size() == theGenParticles->capacity() ) ++nBufferAllocations;
+      theGenParticles->push_back(gen.particle(ip));
+      ++nGenParticles;
     }
 
     // Reject particles with late origin vertex (i.e., coming from late decays)
     // This should not happen, but one never knows what users may be up to!
     // For example exotic particles might decay late - keep the decay products in the case.
     XYZTLorentzVector productionVertexPosition(0.,0.,0.,0.);
-    HepMC::GenVertex* productionVertex = p->production_vertex();
-    if ( productionVertex ) { 
-      unsigned productionMother = productionVertex->particles_in_size();
-      if ( productionMother ) {
-	unsigned motherId = (*(productionVertex->particles_in_const_begin()))->pdg_id();
-	if ( abs(motherId) < 1000000 ) 
-	  productionVertexPosition = 
-	    XYZTLorentzVector(productionVertex->position().x()/10.,
-			      productionVertex->position().y()/10.,
-			      productionVertex->position().z()/10.,
-			      productionVertex->position().t()/10.) + smearedVertex;
-      }
-    }
+    int mother = gen.mother(ip);
+    if ( mother >= 0 && abs(gen.pdgId(mother)) < 1000000 ) 
+      productionVertexPosition = gen.productionVertex(ip) + smearedVertex;
     if ( !myFilter->accept(productionVertexPosition) ) continue;
 
-    int abspdgId = abs(p->pdg_id());
-    HepMC::GenVertex* endVertex = p->end_vertex();
-
-    // Keep only: 
-    // 1) Stable particles (watch out! New status code = 1001!)
-    bool testStable = p->status()%1000==1;
-    // Declare stable standard particles that decay after a macroscopic path length
-    // (except if exotic)
-    if ( p->status() == 2 && abspdgId < 1000000) {
-      if ( endVertex ) { 
-	XYZTLorentzVector decayPosition = 
-	  XYZTLorentzVector(endVertex->position().x()/10.,
-			    endVertex->position().y()/10.,
-			    endVertex->position().z()/10.,
-			    endVertex->position().t()/10.) + smearedVertex;
-	// If the particle flew enough to be beyond the beam pipe enveloppe, just declare it stable
-	if ( decayPosition.Perp2() > lateVertexPosition ) testStable = true;
-      }
-    }      
-
-    // 2) or particles with stable daughters (watch out! New status code = 1001!)
-    bool testDaugh = false;
-    if ( !testStable && 
-	 p->status() == 2 &&
-	 endVertex && 
-	 endVertex->particles_out_size() ) { 
-      HepMC::GenVertex::particles_out_const_iterator firstDaughterIt = 
-	endVertex->particles_out_const_begin();
-      HepMC::GenVertex::particles_out_const_iterator lastDaughterIt = 
-	endVertex->particles_out_const_end();
-      for ( ; firstDaughterIt != lastDaughterIt ; ++firstDaughterIt ) {
-	HepMC::GenParticle* daugh = *firstDaughterIt;
-	if ( daugh->status()%1000==1 ) {
-	  // Check that it is not a "prompt electron or muon brem":
-	  if (abspdgId == 11 || abspdgId == 13) {
-	    if ( endVertex ) { 
-	      XYZTLorentzVector endVertexPosition = XYZTLorentzVector(endVertex->position().x()/10.,
-								      endVertex->position().y()/10.,
-								      endVertex->position().z()/10.,
-								      endVertex->position().t()/10.);
-	      // If the particle flew enough to be beyond the beam pipe enveloppe, just declare it stable
-	      if ( endVertexPosition.Perp2() < lateVertexPosition ) {
-		break;
-	      }
-	    }
-	  }
-	  testDaugh=true;
-	  break;
-	}
-      }
-    }
-
-    // 3) or particles that fly more than one micron.
-    double dist = 0.;
-    if ( !testStable && !testDaugh && p->production_vertex() ) {
-      XYZTLorentzVector 
-	productionVertexPosition(p->production_vertex()->position().x()/10.,
-				 p->production_vertex()->position().y()/10.,
-				 p->production_vertex()->position().z()/10.,
-				 p->production_vertex()->position().t()/10.);
-      dist = (primaryVertexPosition-productionVertexPosition).Vect().Mag2();
-    }
-    bool testDecay = ( dist > 1e-8 ) ? true : false; 
+    bool hasEndVertex = gen.hasEndVertex(ip);
+    bool testStable = gen.declaredStable(ip);
 
     // Save the corresponding particle and vertices
-    if ( testStable || testDaugh || testDecay ) {
+    if ( gen.kept(ip) ) {
       
-      /*
-      const HepMC::GenParticle* mother = p->production_vertex() ?
-	*(p->production_vertex()->particles_in_const_begin()) : 0;
-      */
-
-      int motherBarcode = p->production_vertex() && 
-	p->production_vertex()->particles_in_const_begin() !=
-	p->production_vertex()->particles_in_const_end() ?
-	(*(p->production_vertex()->particles_in_const_begin()))->barcode() : 0;
-
       int originVertex = 
-	motherBarcode && myGenVertices[motherBarcode-initialBarcode] ?
-	myGenVertices[motherBarcode-initialBarcode] : mainVertex;
+	mother >= 0 && myGenVertices[mother] ? myGenVertices[mother] : mainVertex;
 
-      XYZTLorentzVector momentum(p->momentum().px(),
-				 p->momentum().py(),
-				 p->momentum().pz(),
-				 p->momentum().e());
-      RawParticle part(momentum, vertex(originVertex).position());
-      part.setID(p->pdg_id());
+      RawParticle part(gen.momentum(ip), vertex(originVertex).position());
+      part.setID(gen.pdgId(ip));
 
       // Add the particle to the event and to the various lists
       
-      int theTrack = testStable && p->end_vertex() ? 
+      int theTrack = testStable && hasEndVertex ? 
 	// The particle is scheduled to decay
-	addSimTrack(&part,originVertex, nGenParts()-offset,p->end_vertex()) :
+	addSimTrack(&part,originVertex, nGenParts()-offset,gen.particle(ip)->end_vertex()) :
         // The particle is not scheduled to decay 
 	addSimTrack(&part,originVertex, nGenParts()-offset);
 
       if ( 
 	  // This one deals with particles with no end vertex
-	  !p->end_vertex() ||
+	  !hasEndVertex ||
 	  // This one deals with particles that have a pre-defined
 	  // decay proper time, but have not decayed yet
-	  ( testStable && p->end_vertex() &&  !p->end_vertex()->particles_out_size() ) 
+	  ( testStable && !gen.nDaughters(ip) ) 
 	  // In both case, just don't add a end vertex in the FSimEvent 
 	  ) continue; 
       
       // Add the vertex to the event and to the various lists
-      XYZTLorentzVector decayVertex = 
-	XYZTLorentzVector(p->end_vertex()->position().x()/10.,
-			  p->end_vertex()->position().y()/10.,
-			  p->end_vertex()->position().z()/10.,
-			  p->end_vertex()->position().t()/10.) +
-	smearedVertex;
+      XYZTLorentzVector decayVertex = gen.endVertex(ip) + smearedVertex;
       //	vertex(mainVertex).position();
       int theVertex = addSimVertex(decayVertex,theTrack, FSimVertexType::DECAY_VERTEX);
 
-      if ( theVertex != -1 ) myGenVertices[p->barcode()-initialBarcode] = theVertex;
+      if ( theVertex != -1 ) myGenVertices[ip] = theVertex;
 
       // There we are !
     }
@@ -638,6 +973,35 @@ FBaseSimEvent::addParticles(const HepMC::GenEvent& myGenEvent) {
 
 }
 
+namespace {
+
+  /// The particle a mother or daughter reference points to (0 if null),
+  /// and its index in the collection (n, the collection size, if it is 
+  /// not in the collection). The references of a pruned or merged 
+  /// collection may point to another product: the key is an index in the
+  /// collection only if the reference has its product id, found from the
+  /// first reference that points into the collection.
+  const reco::GenParticle* genParticle(const reco::GenParticleRef& ref,
+				       const reco::GenParticleCollection& particles,
+				       edm::ProductID& collection,
+				       unsigned& index) {
+    unsigned n = particles.size();
+    index = n;
+    if ( ref.isNull() ) return 0;
+    if ( collection.isValid() && ref.id() == collection ) { 
+      index = ref.key() < n ? ref.key() : n;
+      return index < n ? &particles[index] : 0;
+    }
+    const reco::GenParticle* p = ref.get();
+    if ( !collection.isValid() && ref.key() < n && p == &particles[ref.key()] ) {
+      collection = ref.id();
+      index = ref.key();
+    }
+    return p;
+  }
+
+}
+
 void
 FBaseSimEvent::addParticles(const reco::GenParticleCollection& myGenParticles) {
 
@@ -647,8 +1011,13 @@ FBaseSimEvent::addParticles(const reco::GenParticleCollection& myGenParticles) {
 
   if ( !nParticles ) return;
 
-  /// Some internal array to work with.
-  std::map<const reco::Candidate*,int> myGenVertices;
+  /// Some internal array to work with: the FSimVertex index of the
+  /// end vertex of each particle of the collection (-1 if none).
+  /// The mother and daughter references that point to the same 
+  /// collection give their keys as indices in that array.
+  assign(theGenVertexIndex, nParticles, -1);
+  std::vector<int>& myGenVertices = theGenVertexIndex;
+  edm::ProductID collection;
 
   // Are there particles in the FSimEvent already ? 
   int offset = nTracks();
@@ -677,7 +1046,7 @@ FBaseSimEvent::addParticles(const reco::GenParticleCollection& myGenParticles) {
       theVertexGenerator->X()-theVertexGenerator->beamSpot().X()+theBeamSpot.X(),
       theVertexGenerator->Y()-theVertexGenerator->beamSpot().Y()+theBeamSpot.Y(),
       theVertexGenerator->Z()-theVertexGenerator->beamSpot().Z()+theBeamSpot.Z(),
-      0.);
+      theVertexGenerator->time());
   }
 
   // Set the main vertex
@@ -698,9 +1067,11 @@ FBaseSimEvent::addParticles(const reco::GenParticleCollection& myGenParticles) {
     // This should not happen, but one never knows what users may be up to!
     // For example exotic particles might decay late - keep the decay products in the case.
     XYZTLorentzVector productionVertexPosition(0.,0.,0.,0.);
-    const reco::Candidate* productionMother = p.numberOfMothers() ? p.mother(0) : 0;
-    if ( productionMother ) {
-      unsigned motherId = productionMother->pdgId();
+    unsigned mother = nParticles;
+    const reco::GenParticle* m = p.numberOfMothers() ? 
+      genParticle(p.motherRef(0),myGenParticles,collection,mother) : 0;
+    if ( m ) {
+      int motherId = m->pdgId();
       if ( abs(motherId) < 1000000 )
 	productionVertexPosition = XYZTLorentzVector(p.vx(), p.vy(), p.vz(), 0.) + smearedVertex;
     }
@@ -711,12 +1082,14 @@ FBaseSimEvent::addParticles(const reco::GenParticleCollection& myGenParticles) {
     bool testStable = p.status()%1000==1;
     // Declare stable standard particles that decay after a macroscopic path length 
     // (except if exotic particle)
+    unsigned int nDaughters = p.numberOfDaughters();
+    unsigned daughter = nParticles;
+    const reco::GenParticle* d = nDaughters ? 
+      genParticle(p.daughterRef(0),myGenParticles,collection,daughter) : 0;
     if ( p.status() == 2 && abs(p.pdgId()) < 1000000 ) {
-      unsigned int nDaughters = p.numberOfDaughters();
-      if ( nDaughters ) { 
-	const reco::Candidate* daughter = p.daughter(0);
+      if ( d ) { 
 	XYZTLorentzVector decayPosition = 
-	  XYZTLorentzVector(daughter->vx(), daughter->vy(), daughter->vz(), 0.) + smearedVertex;
+	  XYZTLorentzVector(d->vx(), d->vy(), d->vz(), 0.) + smearedVertex;
 	// If the particle flew enough to be beyond the beam pipe enveloppe, just declare it stable
 	if ( decayPosition.Perp2() > lateVertexPosition ) testStable = true;
       }
@@ -724,13 +1097,14 @@ FBaseSimEvent::addParticles(const reco::GenParticleCollection& myGenParticles) {
 
     // 2) or particles with stable daughters
     bool testDaugh = false;
-    unsigned int nDaughters = p.numberOfDaughters();
     if ( !testStable  && 
 	 //	 p.status() == 2 && 
 	 nDaughters ) {  
       for ( unsigned iDaughter=0; iDaughter<nDaughters; ++iDaughter ) {
-	const reco::Candidate* daughter = p.daughter(iDaughter);
-	if ( daughter->status()%1000==1 ) {
+	unsigned key;
+	const reco::GenParticle* di = 
+	  genParticle(p.daughterRef(iDaughter),myGenParticles,collection,key);
+	if ( di && di->status()%1000==1 ) {
 	  testDaugh=true;
 	  break;
 	}
@@ -748,11 +1122,8 @@ FBaseSimEvent::addParticles(const reco::GenParticleCollection& myGenParticles) {
     // Save the corresponding particle and vertices
     if ( testStable || testDaugh || testDecay ) {
       
-      const reco::Candidate* mother = p.numberOfMothers() ? p.mother(0) : 0;
-
       int originVertex = 
-	mother &&  
-	myGenVertices.find(mother) != myGenVertices.end() ? 
+	mother < nParticles && myGenVertices[mother] >= 0 ? 
       	myGenVertices[mother] : mainVertex;
       
       XYZTLorentzVector momentum(p.px(),p.py(),p.pz(),p.energy());
@@ -763,16 +1134,14 @@ FBaseSimEvent::addParticles(const reco::GenParticleCollection& myGenParticles) {
       int theTrack = addSimTrack(&part,originVertex, nGenParts()-offset);
 
       // It there an end vertex ?
-      if ( !nDaughters ) continue; 
-      const reco::Candidate* daughter = p.daughter(0);
+      if ( !d ) continue; 
 
       // Add the vertex to the event and to the various lists
       XYZTLorentzVector decayVertex = 
-	XYZTLorentzVector(daughter->vx(), daughter->vy(),
-			  daughter->vz(), 0.) + smearedVertex;
+	XYZTLorentzVector(d->vx(), d->vy(), d->vz(), 0.) + smearedVertex;
       int theVertex = addSimVertex(decayVertex,theTrack, FSimVertexType::DECAY_VERTEX);
 
-      if ( theVertex != -1 ) myGenVertices[&p] = theVertex;
+      if ( theVertex != -1 ) myGenVertices[ip] = theVertex;
 
       // There we are !
     }
@@ -793,15 +1162,11 @@ FBaseSimEvent::addSimTrack(const RawParticle* p, int iv, int ig,
 
   // The new track index
   int trackId = nSimTracks++;
-  if ( nSimTracks/theTrackSize*theTrackSize == nSimTracks ) {
-    theTrackSize *= 2;
-    theSimTracks->resize(theTrackSize);
-  }
 
   // Attach the particle to the origin vertex, and to the mother
-  vertex(iv).addDaughter(trackId);
+  theVertexDaughters->add(iv,trackId);
   if ( !vertex(iv).noParent() ) {
-    track(vertex(iv).parent().id()).addDaughter(trackId);
+    theTrackDaughters->add(vertex(iv).parent().id(),trackId);
 
     if ( ig == -1 ) {
       int motherId = track(vertex(iv).parent().id()).genpartIndex();
@@ -809,15 +1174,23 @@ FBaseSimEvent::addSimTrack(const RawParticle* p, int iv, int ig,
     }
   }
     
-  // Some transient information for FAMOS internal use
-  (*theSimTracks)[trackId] = ev ? 
-    // A proper decay time is scheduled
-    FSimTrack(p,iv,ig,trackId,this,
-	      ev->position().t()/10.
-	      * p->PDGmass()
-	      / std::sqrt(p->momentum().Vect().Mag2())) : 
+  // The frequently accessed quantities, in the track columns
+  theTrackColumns->add(p->momentum(),p->pid(),p->charge(),iv,ig);
+
+  // Some transient information for FAMOS internal use, 
+  // constructed in place (the memory is kept from the previous events)
+  if ( theSimTracks->size() == theSimTracks->capacity() ) ++nBufferAllocations;
+  int species = theParticleProperties->index(p->pid());
+  if ( ev ) { 
+    // A proper decay time is scheduled (with the mass from the table)
+    double mass = species >= 0 ? theParticleProperties->mass(species) : p->PDGmass();
+    theSimTracks->emplace_back(p,iv,ig,trackId,species,this,
+			       ev->position().t()/10.
+			       * mass
+			       / std::sqrt(p->momentum().Vect().Mag2()));
+  } else 
     // No proper decay time is scheduled
-    FSimTrack(p,iv,ig,trackId,this);
+    theSimTracks->emplace_back(p,iv,ig,trackId,species,this);
 
   return trackId;
 
@@ -831,19 +1204,17 @@ FBaseSimEvent::addSimVertex(const XYZTLorentzVector& v, int im, FSimVertexType::
 
   // The number of vertices
   int vertexId = nSimVertices++;
-  if ( nSimVertices/theVertexSize*theVertexSize == nSimVertices ) {
-    theVertexSize *= 2;
-    theSimVertices->resize(theVertexSize);
-    theFSimVerticesType->resize(theVertexSize);
-  }
 
   // Attach the end vertex to the particle (if accepted)
   if ( im !=-1 ) track(im).setEndVertex(vertexId);
 
-  // Some transient information for FAMOS internal use
-  (*theSimVertices)[vertexId] = FSimVertex(v,im,vertexId,this);
+  // Some transient information for FAMOS internal use, 
+  // constructed in place (the memory is kept from the previous events)
+  if ( theSimVertices->size() == theSimVertices->capacity() ) ++nBufferAllocations;
+  theSimVertices->emplace_back(v,im,vertexId,this);
 
-  (*theFSimVerticesType)[vertexId] = FSimVertexType(type);
+  if ( theFSimVerticesType->size() == theFSimVerticesType->capacity() ) ++nBufferAllocations;
+  theFSimVerticesType->emplace_back(type);
 
   return vertexId;
 
@@ -964,21 +1335,53 @@ FBaseSimEvent::print() const {
 void 
 FBaseSimEvent::clear() {
 
+  // Adapt the buffer sizes to the event just processed
+  adaptCapacity();
+
   nSimTracks = 0;
   nSimVertices = 0;
   nGenParticles = 0;
   nChargedParticleTracks = 0;
 
+  // The vectors keep their memory
+  theGenParticles->clear();
+  theGenRecord->clear();
+  theSimTracks->clear();
+  theTrackColumns->clear();
+  theSimVertices->clear();
+  theFSimVerticesType->clear();
+  theChargedTracks->clear();
+
+  // The calorimeter entrance states and the decay tree of the previous event
+  theLazyLevel.clear();
+  theSurfaceTable->clear();
+  theVertexDaughters->clear();
+  theTrackDaughters->clear();
+
+}
+
+unsigned long
+FBaseSimEvent::nAllocations() const { 
+  return nBufferAllocations 
+    + theTrackColumns->nAllocations()
+    + theSurfaceTable->nAllocations()
+    + theGenRecord->nAllocations()
+    + theTrackIdTable->nAllocations()
+    + theVertexDaughters->nAllocations()
+    + theTrackDaughters->nAllocations();
+}
+
+void
+FBaseSimEvent::assign(std::vector<int>& array, unsigned n, int value) { 
+  if ( n > array.capacity() ) ++nBufferAllocations;
+  array.assign(n,value);
 }
 
 void 
 FBaseSimEvent::addChargedTrack(int id) { 
-  (*theChargedTracks)[nChargedParticleTracks++] = id;
-  if ( nChargedParticleTracks/theChargedSize*theChargedSize 
-       == nChargedParticleTracks ) {
-    theChargedSize *= 2;
-    theChargedTracks->resize(theChargedSize);
-  }
+  if ( theChargedTracks->size() == theChargedTracks->capacity() ) ++nBufferAllocations;
+  theChargedTracks->push_back(id);
+  ++nChargedParticleTracks;
 }
 
 int
@@ -1003,7 +1406,8 @@ FBaseSimEvent::embdVertex(int i) const {
 
 const HepMC::GenParticle* 
 FBaseSimEvent::embdGenpart(int i) const {
-  return (*theGenParticles)[i]; 
+  // No GenParticle's are kept when filled from a reco::GenParticleCollection
+  return i>=0 && i<(int)theGenParticles->size() ? (*theGenParticles)[i] : 0; 
 }
 
 /*
@@ -0,0 +1,355 @@
+//FAMOS Headers
+#include "FastSimulation/Event/interface/FSimBatchPropagator.h"
+#include "FastSimulation/Event/interface/FSimSurfaceGeometry.h"
+#include "FastSimulation/Event/interface/FSimPropagationPlan.h"
+#include "FastSimulation/Particle/interface/RawParticle.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+  // Conversion from the radius of curvature (cm) times the field (T)
+  // to the transverse momentum (GeV/c)
+  const double cB = 2.99792458E-3;
+
+  // A path length that is never reached
+  const double never = 1E30;
+
+  const double twoPi = 2.*M_PI;
+
+  using namespace FSimSurfaceGeometry;
+
+  // cos^2(theta) of the position (x,y,z)
+  inline double cos2Theta(double x, double y, double z) {
+    double r2 = x*x+y*y+z*z;
+    return r2 > 0. ? z*z/r2 : 1.;
+  }
+
+}
+
+FSimBatchPropagator::FSimBatchPropagator(double bField) : bField_(bField) {;}
+
+void
+FSimBatchPropagator::Surface::resize(unsigned n) {
+  x.resize(n); y.resize(n); z.resize(n); t.resize(n);
+  px.resize(n); py.resize(n); pz.resize(n);
+  success.resize(n);
+}
+
+unsigned long
+FSimBatchPropagator::Surface::memory() const {
+  return 7*x.capacity()*sizeof(double) + success.capacity()*sizeof(int);
+}
+
+void
+FSimBatchPropagator::clear() {
+  x_.clear(); y_.clear(); z_.clear(); t_.clear();
+  px_.clear(); py_.clear(); pz_.clear(); e_.clear(); q_.clear();
+  pt_.clear(); rho_.clear(); xc_.clear(); yc_.clear(); phi_.clear();
+}
+
+unsigned long
+FSimBatchPropagator::memory() const {
+  unsigned long m =
+    15*x_.capacity()*sizeof(double) +
+    path_.capacity()*sizeof(double) +
+    ( vfcal_.capacity() + side_.capacity() ) * sizeof(int) +
+    work_.memory();
+  for ( unsigned s=0; s<FSimSurfaceTable::NSURFACES; ++s )
+    m += out_[s].memory();
+  return m;
+}
+
+void
+FSimBatchPropagator::add(const math::XYZTLorentzVector& pos,
+			 const math::XYZTLorentzVector& mom,
+			 float charge) {
+
+  x_.push_back(pos.X()); y_.push_back(pos.Y());
+  z_.push_back(pos.Z()); t_.push_back(pos.T());
+  px_.push_back(mom.Px()); py_.push_back(mom.Py());
+  pz_.push_back(mom.Pz()); e_.push_back(mom.E());
+  q_.push_back(charge);
+
+  // The helix (a straight line for neutral particles)
+  double pt = std::sqrt(mom.Px()*mom.Px()+mom.Py()*mom.Py());
+  double phi = std::atan2(mom.Py(),mom.Px());
+  double rho = charge != 0. && bField_ != 0. ? pt/(cB*bField_*charge) : 0.;
+  pt_.push_back(pt);
+  phi_.push_back(phi);
+  rho_.push_back(rho);
+  xc_.push_back(pos.X() + rho*std::sin(phi));
+  yc_.push_back(pos.Y() - rho*std::cos(phi));
+
+}
+
+void
+FSimBatchPropagator::cylinder(const FSimSurfaceGeometry::Cylinder& c) {
+
+  const unsigned n = size();
+  const double r2 = c.radius*c.radius;
+  const double z = c.halfLength;
+
+  for ( unsigned i=0; i<n; ++i ) {
+
+    const double pt = pt_[i];
+    const double rho = rho_[i];
+    const double ipt = pt > 0. ? 1./pt : 0.;
+
+    // Transverse path length to the endcap disk
+    const double zEnd = pz_[i] > 0. ? z : -z;
+    const double lEnd = pz_[i] != 0. && pt > 0. ?
+      std::fmax((zEnd-z_[i])*pt/pz_[i],0.) : never;
+
+    // Transverse path length to the barrel: straight line
+    const double cphi = px_[i]*ipt;
+    const double sphi = py_[i]*ipt;
+    const double b = x_[i]*cphi + y_[i]*sphi;
+    const double d = b*b - x_[i]*x_[i] - y_[i]*y_[i] + r2;
+    const double lLine = d >= 0. ? -b + std::sqrt(std::fmax(d,0.)) : never;
+
+    // Transverse path length to the barrel: helix. The helix crosses
+    // the cylinder at the azimuths phi (of the momentum) for which
+    // sin(phi-alpha) = s, with alpha the azimuth of the helix centre.
+    const double dc2 = xc_[i]*xc_[i] + yc_[i]*yc_[i];
+    const double den = 2.*rho*std::sqrt(dc2);
+    const double s = den != 0. ? (dc2+rho*rho-r2)/den : 2.;
+    const double as = std::asin(std::fmin(std::fmax(s,-1.),1.));
+    const double alpha = std::atan2(yc_[i],xc_[i]);
+    const double sign = rho > 0. ? 1. : -1.;
+    // The particle moves along the helix with phi = phi0 - l/rho
+    double a1 = sign*(phi_[i]-alpha-as);
+    double a2 = sign*(phi_[i]-alpha-M_PI+as);
+    a1 -= twoPi*std::floor(a1/twoPi);
+    a2 -= twoPi*std::floor(a2/twoPi);
+    const double lHelix = std::fabs(s) <= 1. ?
+      std::fabs(rho)*std::fmin(a1,a2) : never;
+
+    const double lBarrel = pt > 0. ? ( rho != 0. ? lHelix : lLine ) : never;
+
+    // The first surface met
+    const double l = std::fmin(lBarrel,lEnd);
+    side_[i] = l >= never ? 0 : ( lBarrel <= lEnd ? 1 : 2 );
+    path_[i] = l >= never ? 0. : l;
+
+  }
+
+}
+
+void
+FSimBatchPropagator::move(Surface& s) const {
+
+  const unsigned n = size();
+
+  for ( unsigned i=0; i<n; ++i ) {
+
+    const double l = path_[i];
+    const double rho = rho_[i];
+    const double pt = pt_[i];
+    const double ipt = pt > 0. ? 1./pt : 0.;
+
+    // Helix
+    const double phi = phi_[i] - ( rho != 0. ? l/rho : 0. );
+    const double cphi = std::cos(phi);
+    const double sphi = std::sin(phi);
+
+    s.x[i] = rho != 0. ? xc_[i] - rho*sphi : x_[i] + l*px_[i]*ipt;
+    s.y[i] = rho != 0. ? yc_[i] + rho*cphi : y_[i] + l*py_[i]*ipt;
+    s.px[i] = rho != 0. ? pt*cphi : px_[i];
+    s.py[i] = rho != 0. ? pt*sphi : py_[i];
+    s.z[i] = z_[i] + l*pz_[i]*ipt;
+    s.pz[i] = pz_[i];
+    s.t[i] = t_[i] + l*e_[i]*ipt;
+    s.success[i] = side_[i];
+
+  }
+
+}
+
+void
+FSimBatchPropagator::straight(const Surface& from, 
+			      const FSimSurfaceGeometry::Cylinder& c, 
+			      Surface& to) {
+
+  const unsigned n = size();
+  const double r2 = c.radius*c.radius;
+  const double z = c.halfLength;
+
+  for ( unsigned i=0; i<n; ++i ) {
+
+    const double pt = std::sqrt(from.px[i]*from.px[i]+from.py[i]*from.py[i]);
+    const double ipt = pt > 0. ? 1./pt : 0.;
+    const double pz = from.pz[i];
+
+    // Transverse path length to the endcap disk and to the barrel
+    const double zEnd = pz > 0. ? z : -z;
+    const double lEnd = pz != 0. && pt > 0. ?
+      std::fmax((zEnd-from.z[i])*pt/pz,0.) : never;
+    const double cphi = from.px[i]*ipt;
+    const double sphi = from.py[i]*ipt;
+    const double b = from.x[i]*cphi + from.y[i]*sphi;
+    const double d = b*b - from.x[i]*from.x[i] - from.y[i]*from.y[i] + r2;
+    const double lBarrel = d >= 0. && pt > 0. ? -b + std::sqrt(std::fmax(d,0.)) : never;
+
+    const double l0 = std::fmin(lBarrel,lEnd);
+    const double l = l0 >= never ? 0. : l0;
+
+    to.x[i] = from.x[i] + l*cphi;
+    to.y[i] = from.y[i] + l*sphi;
+    to.z[i] = from.z[i] + l*pz*ipt;
+    to.t[i] = from.t[i] + l*e_[i]*ipt;
+    to.px[i] = from.px[i];
+    to.py[i] = from.py[i];
+    to.pz[i] = pz;
+    to.success[i] = l0 >= never ? 0 : ( lBarrel <= lEnd ? 1 : 2 );
+
+  }
+
+}
+
+void
+FSimBatchPropagator::select(Surface& s, const std::vector<int>& sel) const {
+
+  const unsigned n = size();
+
+  for ( unsigned i=0; i<n; ++i ) {
+    const bool k = sel[i];
+    s.x[i] = k ? work_.x[i] : s.x[i];
+    s.y[i] = k ? work_.y[i] : s.y[i];
+    s.z[i] = k ? work_.z[i] : s.z[i];
+    s.t[i] = k ? work_.t[i] : s.t[i];
+    s.px[i] = k ? work_.px[i] : s.px[i];
+    s.py[i] = k ? work_.py[i] : s.py[i];
+    s.pz[i] = k ? work_.pz[i] : s.pz[i];
+    s.success[i] = k ? work_.success[i] : s.success[i];
+  }
+
+}
+
+void
+FSimBatchPropagator::skip(Surface& s) const {
+  std::fill(s.success.begin(),s.success.end(),0);
+}
+
+void
+FSimBatchPropagator::propagate(unsigned steps) {
+
+  const unsigned n = size();
+  for ( unsigned s=0; s<FSimSurfaceTable::NSURFACES; ++s ) out_[s].resize(n);
+  work_.resize(n);
+  path_.resize(n);
+  side_.resize(n);
+  vfcal_.resize(n);
+
+  // Preshower layer 1 and layer 2 : only the disks
+  const double rMax2 = preshowerRMax*preshowerRMax;
+  const double rMin2 = preshowerRMin*preshowerRMin;
+  Surface& layer1 = out_[FSimSurfaceTable::LAYER1];
+  if ( steps & FSimPropagationPlan::bit(FSimSurfaceTable::LAYER1) ) { 
+    cylinder(FSimSurfaceGeometry::layer1);
+    move(layer1);
+    for ( unsigned i=0; i<n; ++i ) {
+      const double r2 = layer1.x[i]*layer1.x[i] + layer1.y[i]*layer1.y[i];
+      layer1.success[i] = r2 > rMax2 || r2 < rMin2 ? 0 : layer1.success[i];
+    }
+  } else { 
+    skip(layer1);
+  }
+
+  Surface& layer2 = out_[FSimSurfaceTable::LAYER2];
+  if ( steps & FSimPropagationPlan::bit(FSimSurfaceTable::LAYER2) ) { 
+    cylinder(FSimSurfaceGeometry::layer2);
+    move(layer2);
+    for ( unsigned i=0; i<n; ++i ) {
+      const double r2 = layer2.x[i]*layer2.x[i] + layer2.y[i]*layer2.y[i];
+      layer2.success[i] = r2 > rMax2 || r2 < rMin2 ? 0 : layer2.success[i];
+    }
+  } else { 
+    skip(layer2);
+  }
+
+  // ECAL entrance : the barrel, or the endcap beyond |eta| = 1.479
+  Surface& ecal = out_[FSimSurfaceTable::ECAL];
+  if ( steps & FSimPropagationPlan::bit(FSimSurfaceTable::ECAL) ) { 
+    cylinder(ecalBarrel);
+    move(ecal);
+    cylinder(ecalEndcap);
+    move(work_);
+    for ( unsigned i=0; i<n; ++i )
+      side_[i] = ecal.success[i] == 1 &&
+	cos2Theta(ecal.x[i],ecal.y[i],ecal.z[i]) > cos2EtaEB;
+    select(ecal,side_);
+    for ( unsigned i=0; i<n; ++i )
+      ecal.success[i] = cos2Theta(ecal.x[i],ecal.y[i],ecal.z[i]) > cos2Eta3 ? 0 : ecal.success[i];
+  } else { 
+    skip(ecal);
+  }
+
+  // HCAL entrance : the barrel, or the endcap (needed for all the 
+  // surfaces beyond)
+  Surface& hcal = out_[FSimSurfaceTable::HCAL];
+  if ( !( steps & FSimPropagationPlan::bit(FSimSurfaceTable::HCAL) ) ) { 
+    for ( unsigned s=FSimSurfaceTable::HCAL; s<FSimSurfaceTable::NSURFACES; ++s ) skip(out_[s]);
+    return;
+  }
+  cylinder(hcalBarrel);
+  move(hcal);
+  cylinder(hcalEndcap);
+  move(work_);
+  for ( unsigned i=0; i<n; ++i ) side_[i] = hcal.success[i] == 2;
+  select(hcal,side_);
+  for ( unsigned i=0; i<n; ++i ) {
+    const double c2 = cos2Theta(hcal.x[i],hcal.y[i],hcal.z[i]);
+    hcal.success[i] = c2 > cos2Eta3 ? 0 : hcal.success[i];
+    // Attempt propagation to HF for low pt and high eta
+    vfcal_[i] = c2 > vfcalCos2Theta || e_[i] < vfcalEMax;
+  }
+
+  // VFCAL entrance : 3 < |eta| < 5
+  Surface& vfcal = out_[FSimSurfaceTable::VFCAL];
+  if ( steps & FSimPropagationPlan::bit(FSimSurfaceTable::VFCAL) ) { 
+    cylinder(FSimSurfaceGeometry::vfcal);
+    move(vfcal);
+    for ( unsigned i=0; i<n; ++i ) {
+      const double c2 = cos2Theta(vfcal.x[i],vfcal.y[i],vfcal.z[i]);
+      vfcal.success[i] = vfcal.success[i] == 2 && c2 > cos2Eta3 && c2 < cos2Eta5 ? 2 : 0;
+    }
+  } else { 
+    skip(vfcal);
+  }
+
+  // HCAL exit (needed for HO)
+  Surface& hcalExit = out_[FSimSurfaceTable::HCALEXIT];
+  Surface& ho = out_[FSimSurfaceTable::HO];
+  if ( !( steps & FSimPropagationPlan::bit(FSimSurfaceTable::HCALEXIT) ) ) { 
+    skip(hcalExit);
+    skip(ho);
+    return;
+  }
+  cylinder(FSimSurfaceGeometry::hcalExit);
+  move(hcalExit);
+  for ( unsigned i=0; i<n; ++i )
+    hcalExit.success[i] =
+      cos2Theta(hcalExit.x[i],hcalExit.y[i],hcalExit.z[i]) > cos2Eta3 ? 0 : hcalExit.success[i];
+
+  // HO entrance, in no magnetic field : the barrel only, |eta| < 1.26
+  if ( !( steps & FSimPropagationPlan::bit(FSimSurfaceTable::HO) ) ) { 
+    skip(ho);
+    return;
+  }
+  straight(hcalExit,FSimSurfaceGeometry::ho,ho);
+  for ( unsigned i=0; i<n; ++i )
+    ho.success[i] =
+      ho.success[i] == 1 && cos2Theta(ho.x[i],ho.y[i],ho.z[i]) < cos2EtaHO ? 1 : 0;
+
+}
+
+RawParticle
+FSimBatchPropagator::state(unsigned i, FSimSurfaceTable::Surface s) const {
+  const Surface& o = out_[s];
+  RawParticle p(math::XYZTLorentzVector(o.px[i],o.py[i],o.pz[i],e_[i]),
+		math::XYZTLorentzVector(o.x[i],o.y[i],o.z[i],o.t[i]));
+  p.setCharge(q_[i]);
+  return p;
+}
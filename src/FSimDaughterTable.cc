@@ -0,0 +1,91 @@
+#include "FastSimulation/Event/interface/FSimDaughterTable.h"
+
+#include <algorithm>
+
+FSimDaughterTable::FSimDaughterTable() : nAllocations_(0) {;}
+
+void
+FSimDaughterTable::clear() {
+  first_.clear();
+  size_.clear();
+  room_.clear();
+  children_.clear();
+}
+
+void
+FSimDaughterTable::release() {
+  std::vector<int>().swap(first_);
+  std::vector<int>().swap(size_);
+  std::vector<int>().swap(room_);
+  std::vector<int>().swap(children_);
+  std::vector<int>().swap(buffer_);
+}
+
+unsigned long
+FSimDaughterTable::memory() const {
+  return sizeof(int) * 
+    ( first_.capacity() + size_.capacity() + room_.capacity() + 
+      children_.capacity() + buffer_.capacity() );
+}
+
+void
+FSimDaughterTable::add(int parent, int daughter) {
+
+  // No parent, nothing to attach the daughter to
+  if ( parent < 0 ) return;
+
+  // A new parent
+  if ( parent >= (int)size_.size() ) {
+    if ( parent >= (int)size_.capacity() ) ++nAllocations_;
+    first_.resize(parent+1,0);
+    size_.resize(parent+1,0);
+    room_.resize(parent+1,0);
+  }
+
+  // No room left for this parent: extend its range if it is the last one
+  // in the array, otherwise move it to the end with twice the room.
+  if ( size_[parent] == room_[parent] ) {
+    int room = room_[parent] ? 2*room_[parent] : 2;
+    int end = children_.size();
+    bool last = first_[parent]+room_[parent] == end;
+    // The array grows only if the new end is beyond its capacity
+    int newEnd = last ? first_[parent]+room : end+room;
+    if ( newEnd > (int)children_.capacity() ) ++nAllocations_;
+    children_.resize(newEnd);
+    if ( !last ) {
+      std::copy(children_.begin()+first_[parent],
+		children_.begin()+first_[parent]+size_[parent],
+		children_.begin()+end);
+      first_[parent] = end;
+    }
+    room_[parent] = room;
+  }
+
+  children_[first_[parent]+size_[parent]++] = daughter;
+
+}
+
+void
+FSimDaughterTable::finalize() {
+
+  unsigned nParents = size_.size();
+  int nChildren = 0;
+  for ( unsigned ip=0; ip<nParents; ++ip ) nChildren += size_[ip];
+
+  // Copy the daughters in parent order, without the unused slots
+  if ( nChildren > (int)buffer_.capacity() ) ++nAllocations_;
+  buffer_.resize(nChildren);
+  int offset = 0;
+  for ( unsigned ip=0; ip<nParents; ++ip ) {
+    std::copy(children_.begin()+first_[ip],
+	      children_.begin()+first_[ip]+size_[ip],
+	      buffer_.begin()+offset);
+    first_[ip] = offset;
+    room_[ip] = size_[ip];
+    offset += size_[ip];
+  }
+
+  // The old array is kept as working array for the next call
+  children_.swap(buffer_);
+
+}
@@ -1,5 +1,6 @@
 //FAMOS Headers
 #include "FastSimulation/Event/interface/FSimEvent.h"
+#include "FastSimulation/Event/interface/PrimaryVertexGenerator.h"
 
 //C++ Headers
 
@@ -18,12 +19,14 @@ FSimEvent::~FSimEvent()
 
 void 
 FSimEvent::fill(const reco::GenParticleCollection& parts, edm::EventID& Id) { 
+  thePrimaryVertexGenerator()->setEvent(Id.run(),Id.luminosityBlock(),Id.event());
   FBaseSimEvent::fill(parts); 
   id_ = Id;
 }
     
 void 
 FSimEvent::fill(const HepMC::GenEvent& hev, edm::EventID& Id) { 
+  thePrimaryVertexGenerator()->setEvent(Id.run(),Id.luminosityBlock(),Id.event());
   FBaseSimEvent::fill(hev); 
   id_ = Id;
 }
@@ -62,13 +65,17 @@ FSimEvent::nGenParts() const {
 void 
 FSimEvent::load(edm::SimTrackContainer & c, edm::SimTrackContainer & m) const
 {
+  // The particle types are read from the track columns, so that only
+  // muons need the full track to be looked at.
+  const int* types = trackColumns().types();
+  c.reserve(c.size()+nTracks());
   for (unsigned int i=0; i<nTracks(); ++i) {
     //    SimTrack t = SimTrack(ip,p,iv,ig);
     const SimTrack& t = embdTrack(i);
     // Save all tracks
     c.push_back(t);
     // Save also some muons for later parameterization
-    if ( abs(t.type()) == 13 && 
+    if ( abs(types[i]) == 13 && 
 	 t.momentum().perp2() > 1.0 &&
 	 fabs(t.momentum().eta()) < 3.0 &&
 	 track(i).noEndVertex() ) {
@@ -85,6 +92,7 @@ FSimEvent::load(edm::SimTrackContainer & c, edm::SimTrackContainer & m) const
 void 
 FSimEvent::load(edm::SimVertexContainer & c) const
 {
+  c.reserve(c.size()+nVertices());
   for (unsigned int i=0; i<nVertices(); ++i) {
     //    SimTrack t = SimTrack(ip,p,iv,ig);
     c.push_back(embdVertex(i));
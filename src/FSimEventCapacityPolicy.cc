@@ -0,0 +1,83 @@
+//Framework Headers
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+//Famos Headers
+#include "FastSimulation/Event/interface/FSimEventCapacityPolicy.h"
+
+#include <algorithm>
+
+FSimEventCapacityPolicy::FSimEventCapacityPolicy() :
+  theInitialSize(5000),
+  theWindow(100),
+  thePercentile(0.95),
+  theHeadroom(1.2),
+  theOutlierFactor(2.),
+  theReleaseAfter(50),
+  theNext(0),
+  theTarget(theInitialSize),
+  nNormalEvents(0)
+{}
+
+FSimEventCapacityPolicy::FSimEventCapacityPolicy(const edm::ParameterSet& buffers) :
+  theInitialSize(buffers.getUntrackedParameter<unsigned>("initialSize",5000)),
+  theWindow(buffers.getUntrackedParameter<unsigned>("window",100)),
+  thePercentile(buffers.getUntrackedParameter<double>("percentile",0.95)),
+  theHeadroom(buffers.getUntrackedParameter<double>("headroom",1.2)),
+  theOutlierFactor(buffers.getUntrackedParameter<double>("outlierFactor",2.)),
+  theReleaseAfter(buffers.getUntrackedParameter<unsigned>("releaseAfter",50)),
+  theNext(0),
+  theTarget(theInitialSize),
+  nNormalEvents(0)
+{
+  // Protection against paranoid people
+  if ( theWindow < 1 ) theWindow = 1;
+  if ( thePercentile > 1. ) thePercentile = 1.;
+  if ( thePercentile < 0. ) thePercentile = 0.;
+  if ( theHeadroom < 1. ) theHeadroom = 1.;
+  if ( theOutlierFactor < 1. ) theOutlierFactor = 1.;
+}
+
+void
+FSimEventCapacityPolicy::record(unsigned size) {
+
+  // Count the consecutive events that fit in the preallocation
+  if ( size <= theTarget )
+    ++nNormalEvents;
+  else
+    nNormalEvents = 0;
+
+  // Remember the last theWindow event sizes
+  if ( theSizes.size() < theWindow ) {
+    theSizes.push_back(size);
+  } else {
+    theSizes[theNext] = size;
+    theNext = (theNext+1) % theWindow;
+  }
+
+  update();
+
+}
+
+void
+FSimEventCapacityPolicy::update() {
+
+  // The requested percentile of the recent event sizes
+  theWork = theSizes;
+  unsigned k = (unsigned)(thePercentile*(theWork.size()-1)+0.5);
+  std::nth_element(theWork.begin(),theWork.begin()+k,theWork.end());
+
+  theTarget = (unsigned)(theHeadroom*theWork[k]) + 1;
+
+}
+
+unsigned
+FSimEventCapacityPolicy::target() const {
+  return theTarget;
+}
+
+bool
+FSimEventCapacityPolicy::release(unsigned capacity) const {
+  return
+    nNormalEvents >= theReleaseAfter &&
+    capacity > theOutlierFactor*theTarget;
+}
@@ -0,0 +1,325 @@
+//HepMC Headers
+#include "HepMC/GenEvent.h"
+#include "HepMC/GenVertex.h"
+#include "HepMC/GenParticle.h"
+
+//Famos Headers
+#include "FastSimulation/Event/interface/FSimGenRecord.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+  // Order the particles by production vertex barcode (then by index)
+  class ByProductionVertex {
+  public:
+    ByProductionVertex(const std::vector<int>& barcodes) : b(barcodes) {;}
+    bool operator()(int i, int j) const {
+      return b[i] < b[j] || ( b[i] == b[j] && i < j );
+    }
+  private:
+    const std::vector<int>& b;
+  };
+
+  // Compare the production vertex barcode of a particle with a barcode
+  class ProducedBefore {
+  public:
+    ProducedBefore(const std::vector<int>& barcodes) : b(barcodes) {;}
+    bool operator()(int i, int barcode) const { return b[i] < barcode; }
+  private:
+    const std::vector<int>& b;
+  };
+
+  class ProducedAfter {
+  public:
+    ProducedAfter(const std::vector<int>& barcodes) : b(barcodes) {;}
+    bool operator()(int barcode, int i) const { return barcode < b[i]; }
+  private:
+    const std::vector<int>& b;
+  };
+
+  // Vertex position, in cm
+  inline math::XYZTLorentzVector position(const HepMC::GenVertex* v) {
+    return math::XYZTLorentzVector(v->position().x()/10.,
+				   v->position().y()/10.,
+				   v->position().z()/10.,
+				   v->position().t()/10.);
+  }
+
+}
+
+FSimGenRecord::FSimGenRecord() : nAllocations_(0) {;}
+
+void
+FSimGenRecord::reserve(unsigned n) {
+  if ( n <= particle_.capacity() ) return;
+  ++nAllocations_;
+  particle_.reserve(n);
+  barcode_.reserve(n);
+  pdgId_.reserve(n);
+  status_.reserve(n);
+  momentum_.reserve(n);
+  productionBarcode_.reserve(n);
+  production_.reserve(n);
+  endBarcode_.reserve(n);
+  end_.reserve(n);
+  mother_.reserve(n);
+  firstDaughter_.reserve(n);
+  nDaughters_.reserve(n);
+  daughters_.reserve(n);
+  stableCount_.reserve(n+1);
+  keep_.reserve(n);
+  stable_.reserve(n);
+}
+
+void
+FSimGenRecord::clear() {
+  particle_.clear();
+  barcode_.clear();
+  pdgId_.clear();
+  status_.clear();
+  momentum_.clear();
+  productionBarcode_.clear();
+  production_.clear();
+  endBarcode_.clear();
+  end_.clear();
+  mother_.clear();
+  firstDaughter_.clear();
+  nDaughters_.clear();
+  daughters_.clear();
+  stableCount_.clear();
+  keep_.clear();
+  stable_.clear();
+}
+
+void
+FSimGenRecord::release() {
+  FSimGenRecord empty;
+  std::swap(particle_,empty.particle_);
+  std::swap(barcode_,empty.barcode_);
+  std::swap(pdgId_,empty.pdgId_);
+  std::swap(status_,empty.status_);
+  std::swap(momentum_,empty.momentum_);
+  std::swap(productionBarcode_,empty.productionBarcode_);
+  std::swap(production_,empty.production_);
+  std::swap(endBarcode_,empty.endBarcode_);
+  std::swap(end_,empty.end_);
+  std::swap(mother_,empty.mother_);
+  std::swap(firstDaughter_,empty.firstDaughter_);
+  std::swap(nDaughters_,empty.nDaughters_);
+  std::swap(daughters_,empty.daughters_);
+  std::swap(stableCount_,empty.stableCount_);
+  std::swap(keep_,empty.keep_);
+  std::swap(stable_,empty.stable_);
+}
+
+unsigned long
+FSimGenRecord::memory() const {
+  return
+    particle_.capacity()*sizeof(HepMC::GenParticle*) +
+    ( momentum_.capacity() + production_.capacity() + end_.capacity() )
+    * sizeof(math::XYZTLorentzVector) +
+    ( barcode_.capacity() + pdgId_.capacity() + status_.capacity() +
+      productionBarcode_.capacity() + endBarcode_.capacity() + mother_.capacity() +
+      firstDaughter_.capacity() + nDaughters_.capacity() + daughters_.capacity() +
+      stableCount_.capacity() + keep_.capacity() + stable_.capacity() )
+    * sizeof(int);
+}
+
+int
+FSimGenRecord::index(int barcode) const {
+
+  // The particles are ordered by increasing barcode, most often
+  // without gaps: try the direct position first
+  if ( barcode_.empty() ) return -1;
+  int i = barcode - barcode_[0];
+  if ( i >= 0 && i < (int)barcode_.size() && barcode_[i] == barcode ) return i;
+
+  std::vector<int>::const_iterator it =
+    std::lower_bound(barcode_.begin(),barcode_.end(),barcode);
+  return it != barcode_.end() && *it == barcode ? it-barcode_.begin() : -1;
+
+}
+
+void
+FSimGenRecord::fill(const HepMC::GenEvent& myGenEvent) {
+
+  clear();
+  reserve(myGenEvent.particles_size());
+
+  // The particles, with their production and end vertices
+  HepMC::GenEvent::particle_const_iterator piter;
+  HepMC::GenEvent::particle_const_iterator pbegin = myGenEvent.particles_begin();
+  HepMC::GenEvent::particle_const_iterator pend = myGenEvent.particles_end();
+  for ( piter = pbegin; piter != pend; ++piter ) {
+
+    HepMC::GenParticle* p = *piter;
+    particle_.push_back(p);
+    barcode_.push_back(p->barcode());
+    pdgId_.push_back(p->pdg_id());
+    status_.push_back(p->status());
+    momentum_.push_back(math::XYZTLorentzVector(p->momentum().px(),
+						p->momentum().py(),
+						p->momentum().pz(),
+						p->momentum().e()));
+
+    const HepMC::GenVertex* productionVertex = p->production_vertex();
+    productionBarcode_.push_back(productionVertex ? productionVertex->barcode() : 0);
+    production_.push_back(productionVertex ?
+			  position(productionVertex) : math::XYZTLorentzVector());
+
+    const HepMC::GenVertex* endVertex = p->end_vertex();
+    endBarcode_.push_back(endVertex ? endVertex->barcode() : 0);
+    end_.push_back(endVertex ? position(endVertex) : math::XYZTLorentzVector());
+
+  }
+
+  // The mothers
+  const unsigned n = size();
+  for ( unsigned i=0; i<n; ++i ) {
+    const HepMC::GenVertex* productionVertex = particle_[i]->production_vertex();
+    mother_.push_back(productionVertex &&
+		      productionVertex->particles_in_const_begin() !=
+		      productionVertex->particles_in_const_end() ?
+		      index((*(productionVertex->particles_in_const_begin()))->barcode()) : -1);
+  }
+
+  // The daughters of a particle are the particles produced at its
+  // end vertex: order the particles by production vertex
+  for ( unsigned i=0; i<n; ++i ) daughters_.push_back(i);
+  std::sort(daughters_.begin(),daughters_.end(),ByProductionVertex(productionBarcode_));
+  ProducedBefore before(productionBarcode_);
+  ProducedAfter after(productionBarcode_);
+  for ( unsigned i=0; i<n; ++i ) {
+    int first = 0;
+    int last = 0;
+    if ( endBarcode_[i] ) {
+      first = std::lower_bound(daughters_.begin(),daughters_.end(),
+			       endBarcode_[i],before) - daughters_.begin();
+      last = std::upper_bound(daughters_.begin(),daughters_.end(),
+			      endBarcode_[i],after) - daughters_.begin();
+    }
+    firstDaughter_.push_back(first);
+    nDaughters_.push_back(last-first);
+  }
+
+}
+
+void
+FSimGenRecord::classify(const math::XYZTLorentzVector& primaryVertex,
+			const math::XYZTLorentzVector& smearing,
+			double lateVertexPosition) {
+
+  const unsigned n = size();
+  keep_.resize(n);
+  stable_.resize(n);
+  stableCount_.resize(n+1);
+
+  // The number of stable particles among the daughters, from the 
+  // running count of the stable particles ordered by production vertex
+  stableCount_[0] = 0;
+  for ( unsigned k=0; k<n; ++k )
+    stableCount_[k+1] = stableCount_[k] + ( status_[daughters_[k]]%1000 == 1 );
+
+  const double px = primaryVertex.X();
+  const double py = primaryVertex.Y();
+  const double pz = primaryVertex.Z();
+  const double sx = smearing.X();
+  const double sy = smearing.Y();
+
+  for ( unsigned i=0; i<n; ++i ) {
+
+    const int status = status_[i];
+    const int id = pdgId_[i] < 0 ? -pdgId_[i] : pdgId_[i];
+    const bool hasEnd = endBarcode_[i] != 0;
+    const bool hasProduction = productionBarcode_[i] != 0;
+    const double ex = end_[i].X();
+    const double ey = end_[i].Y();
+    const double dx = production_[i].X() - px;
+    const double dy = production_[i].Y() - py;
+    const double dz = production_[i].Z() - pz;
+
+    // 1) Stable particles, and standard particles that decay after a 
+    //    macroscopic path length
+    const double decay2 = (ex+sx)*(ex+sx) + (ey+sy)*(ey+sy);
+    const bool testStable =
+      status%1000 == 1 ||
+      ( status == 2 && id < 1000000 && hasEnd && decay2 > lateVertexPosition );
+
+    // 2) or particles with stable daughters, except prompt e/mu brem
+    const int nStable =
+      stableCount_[firstDaughter_[i]+nDaughters_[i]] - stableCount_[firstDaughter_[i]];
+    const bool promptBrem =
+      ( id == 11 || id == 13 ) && ex*ex + ey*ey < lateVertexPosition;
+    const bool testDaugh =
+      !testStable && status == 2 && hasEnd && nStable > 0 && !promptBrem;
+
+    // 3) or particles that fly more than one micron
+    const double dist = hasProduction ? dx*dx + dy*dy + dz*dz : 0.;
+    const bool testDecay = !testStable && !testDaugh && dist > 1e-8;
+
+    keep_[i] = testStable || testDaugh || testDecay;
+    stable_[i] = testStable;
+
+  }
+
+}
+
+void
+FSimGenRecord::classifyReference(const math::XYZTLorentzVector& primaryVertex,
+				 const math::XYZTLorentzVector& smearing,
+				 double lateVertexPosition) {
+
+  const unsigned n = size();
+  keep_.resize(n);
+  stable_.resize(n);
+
+  for ( unsigned ip=0; ip<n; ++ip ) {
+
+    int abspdgId = abs(pdgId_[ip]);
+
+    // Keep only: 
+    // 1) Stable particles (watch out! New status code = 1001!)
+    bool testStable = status_[ip]%1000==1;
+    // Declare stable standard particles that decay after a macroscopic path length
+    // (except if exotic)
+    if ( status_[ip] == 2 && abspdgId < 1000000) {
+      if ( hasEndVertex(ip) ) { 
+	math::XYZTLorentzVector decayPosition = end_[ip] + smearing;
+	// If the particle flew enough to be beyond the beam pipe enveloppe, just declare it stable
+	if ( decayPosition.Perp2() > lateVertexPosition ) testStable = true;
+      }
+    }      
+
+    // 2) or particles with stable daughters (watch out! New status code = 1001!)
+    bool testDaugh = false;
+    if ( !testStable && 
+	 status_[ip] == 2 &&
+	 hasEndVertex(ip) && 
+	 nDaughters_[ip] ) { 
+      for ( int id = 0; id < nDaughters_[ip]; ++id ) {
+	if ( status_[daughter(ip,id)]%1000==1 ) {
+	  // Check that it is not a "prompt electron or muon brem":
+	  // if the particle did not fly beyond the beam pipe enveloppe, 
+	  // do not consider it
+	  if ( (abspdgId == 11 || abspdgId == 13) && 
+	       end_[ip].Perp2() < lateVertexPosition ) break;
+	  testDaugh=true;
+	  break;
+	}
+      }
+    }
+
+    // 3) or particles that fly more than one micron.
+    double dist = 0.;
+    if ( !testStable && !testDaugh && hasProductionVertex(ip) ) 
+      dist = (primaryVertex-production_[ip]).Vect().Mag2();
+    bool testDecay = ( dist > 1e-8 ) ? true : false; 
+
+    keep_[ip] = testStable || testDaugh || testDecay;
+    stable_[ip] = testStable;
+
+  }
+
+}
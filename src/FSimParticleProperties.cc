@@ -0,0 +1,43 @@
+//Famos Headers
+#include "FastSimulation/Event/interface/FSimParticleProperties.h"
+#include "FastSimulation/Event/interface/KineParticleFilter.h"
+
+#include <algorithm>
+
+FSimParticleProperties::FSimParticleProperties(const HepPDT::ParticleDataTable& pdt,
+					       const KineParticleFilter& filter) :
+  table_(&pdt),
+  dense_(2*NDENSE,-1)
+{
+
+  HepPDT::ParticleDataTable::const_iterator it;
+  for ( it=pdt.begin(); it!=pdt.end(); ++it ) {
+
+    const HepPDT::ParticleData& data = it->second;
+    int id = it->first.pid();
+    int index = pdgId_.size();
+    pdgId_.push_back(id);
+    charge_.push_back(data.charge());
+    mass_.push_back(data.mass().value());
+    cTau_.push_back(data.lifetime().value());
+    unsigned species = id ? filter.species(id < 0 ? -id : id) : 0;
+    simulable_.push_back( ( species & KineParticleFilter::SIMULABLE ) != 0 );
+    forbidden_.push_back( ( species & KineParticleFilter::ALLOWED ) == 0 );
+    data_.push_back(&data);
+
+    if ( id > -NDENSE && id < NDENSE )
+      dense_[id+NDENSE] = index;
+    else
+      sparse_.push_back(std::make_pair(id,index));
+
+  }
+  std::sort(sparse_.begin(),sparse_.end());
+
+}
+
+int
+FSimParticleProperties::sparseIndex(int pdgId) const {
+  std::vector< std::pair<int,int> >::const_iterator it =
+    std::lower_bound(sparse_.begin(),sparse_.end(),std::make_pair(pdgId,-1));
+  return it != sparse_.end() && it->first == pdgId ? it->second : -1;
+}
@@ -0,0 +1,121 @@
+//Framework Headers
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+//Famos Headers
+#include "FastSimulation/Event/interface/FSimPropagationPlan.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+FSimPropagationPlan::FSimPropagationPlan() :
+  theBField(4.),
+  theDefaultMask((1U << FSimSurfaceTable::NSURFACES) - 1),
+  theThresholdMask(0)
+{
+  for ( unsigned s=0; s<FSimSurfaceTable::NSURFACES; ++s ) {
+    thePtMin[s] = 0.;
+    theEMin[s] = 0.;
+  }
+}
+
+FSimPropagationPlan::FSimPropagationPlan(const edm::ParameterSet& plan) :
+  theBField(plan.getParameter<double>("bField")),
+  theDefaultMask(0),
+  theThresholdMask(0)
+{
+
+  std::vector<int> skipped = plan.getParameter< std::vector<int> >("skippedParticles");
+
+  // Read the surfaces, and collect all the species listed
+  std::vector< std::vector<int> > particles(FSimSurfaceTable::NSURFACES);
+  std::vector<int> species;
+  for ( unsigned s=0; s<FSimSurfaceTable::NSURFACES; ++s ) {
+
+    thePtMin[s] = 0.;
+    theEMin[s] = 0.;
+    std::string surface = name((FSimSurfaceTable::Surface)s);
+    if ( !plan.exists(surface) ) continue;
+    edm::ParameterSet cuts = plan.getParameter<edm::ParameterSet>(surface);
+    if ( !cuts.getParameter<bool>("propagate") ) continue;
+
+    thePtMin[s] = cuts.getParameter<double>("pTMin");
+    theEMin[s] = cuts.getParameter<double>("EMin");
+    if ( thePtMin[s] > 0. || theEMin[s] > 0. ) theThresholdMask |= 1U << s;
+
+    particles[s] = cuts.getParameter< std::vector<int> >("particles");
+    for ( unsigned ip=0; ip<particles[s].size(); ++ip )
+      particles[s][ip] = std::abs(particles[s][ip]);
+    std::sort(particles[s].begin(),particles[s].end());
+    species.insert(species.end(),particles[s].begin(),particles[s].end());
+
+    // The species not listed are propagated only if no list is given
+    if ( particles[s].empty() ) theDefaultMask |= 1U << s;
+
+  }
+
+  for ( unsigned ip=0; ip<skipped.size(); ++ip )
+    skipped[ip] = std::abs(skipped[ip]);
+  std::sort(skipped.begin(),skipped.end());
+  species.insert(species.end(),skipped.begin(),skipped.end());
+
+  // Compile the table of the surfaces allowed for each species listed
+  std::sort(species.begin(),species.end());
+  species.erase(std::unique(species.begin(),species.end()),species.end());
+  for ( unsigned ip=0; ip<species.size(); ++ip ) {
+    int id = species[ip];
+    unsigned mask = 0;
+    if ( !std::binary_search(skipped.begin(),skipped.end(),id) ) {
+      mask = theDefaultMask;
+      for ( unsigned s=0; s<FSimSurfaceTable::NSURFACES; ++s )
+	if ( std::binary_search(particles[s].begin(),particles[s].end(),id) )
+	  mask |= 1U << s;
+    }
+    theSpeciesMasks.push_back(std::pair<int,unsigned>(id,mask));
+  }
+
+}
+
+std::string
+FSimPropagationPlan::name(FSimSurfaceTable::Surface s) {
+  switch ( s ) {
+  case FSimSurfaceTable::LAYER1 :   return "Layer1";
+  case FSimSurfaceTable::LAYER2 :   return "Layer2";
+  case FSimSurfaceTable::ECAL :     return "Ecal";
+  case FSimSurfaceTable::HCAL :     return "Hcal";
+  case FSimSurfaceTable::VFCAL :    return "VFcal";
+  case FSimSurfaceTable::HCALEXIT : return "HcalExit";
+  case FSimSurfaceTable::HO :       return "HO";
+  default : return "";
+  }
+}
+
+unsigned
+FSimPropagationPlan::surfaces(int pdgId, double pt, double e) const {
+
+  // The species
+  unsigned mask = theDefaultMask;
+  if ( !theSpeciesMasks.empty() ) {
+    std::pair<int,unsigned> key(std::abs(pdgId),0);
+    std::vector< std::pair<int,unsigned> >::const_iterator it =
+      std::lower_bound(theSpeciesMasks.begin(),theSpeciesMasks.end(),key);
+    if ( it != theSpeciesMasks.end() && it->first == key.first ) mask = it->second;
+  }
+
+  // The kinematics
+  if ( mask & theThresholdMask )
+    for ( unsigned s=0; s<FSimSurfaceTable::NSURFACES; ++s )
+      if ( pt < thePtMin[s] || e < theEMin[s] ) mask &= ~(1U << s);
+
+  return mask;
+
+}
+
+unsigned
+FSimPropagationPlan::steps(unsigned surfaces) {
+  unsigned mask = surfaces;
+  if ( mask & bit(FSimSurfaceTable::HO) )
+    mask |= bit(FSimSurfaceTable::HCALEXIT);
+  if ( mask & ( bit(FSimSurfaceTable::VFCAL) | bit(FSimSurfaceTable::HCALEXIT) ) )
+    mask |= bit(FSimSurfaceTable::HCAL);
+  return mask;
+}
@@ -0,0 +1,46 @@
+#include "FastSimulation/Event/interface/FSimSurfaceTable.h"
+
+const RawParticle FSimSurfaceTable::noState;
+
+FSimSurfaceTable::FSimSurfaceTable() : nAllocations_(0) {;}
+
+void
+FSimSurfaceTable::clear() {
+  index_.clear();
+  states_.clear();
+}
+
+void
+FSimSurfaceTable::release() {
+  std::vector<int>().swap(index_);
+  std::vector<RawParticle>().swap(states_);
+}
+
+unsigned long
+FSimSurfaceTable::memory() const {
+  return 
+    index_.capacity()*sizeof(int) + 
+    states_.capacity()*sizeof(RawParticle);
+}
+
+void
+FSimSurfaceTable::set(int i, Surface s, const RawParticle& pp) {
+
+  if ( i < 0 ) return;
+
+  unsigned k = i*NSURFACES+s;
+  if ( k >= index_.size() ) {
+    if ( (unsigned)((i+1)*NSURFACES) > index_.capacity() ) ++nAllocations_;
+    index_.resize((i+1)*NSURFACES,-1);
+  }
+
+  // Overwrite the previous state, if any
+  if ( index_[k] >= 0 ) {
+    states_[index_[k]] = pp;
+  } else {
+    index_[k] = states_.size();
+    if ( states_.size() == states_.capacity() ) ++nAllocations_;
+    states_.push_back(pp);
+  }
+
+}
@@ -7,24 +7,22 @@
 //using namespace HepPDT;
 
 FSimTrack:: FSimTrack() : 
-  SimTrack(), mom_(0), id_(-1), endv_(-1),
+  SimTrack(), mom_(0), id_(-1),
   layer1(0), layer2(0), ecal(0), hcal(0), vfcal(0), hcalexit(0), hoentr(0), 
-  prop(false), closestDaughterId_(-1), info_(0),
+  prop(false), closestDaughterId_(-1), species_(-1),
   properDecayTime(1E99) {;}
   
 FSimTrack::FSimTrack(const RawParticle* p, 
-		     int iv, int ig, int id, 
+		     int iv, int ig, int id, int species,
 		     FBaseSimEvent* mom,
 		     double dt) :
   //  SimTrack(p->pid(),*p,iv,ig),   // to uncomment once Mathcore is installed 
   SimTrack(p->pid(),p->momentum(),iv,ig), 
-  mom_(mom), id_(id), endv_(-1),
+  mom_(mom), id_(id),
   layer1(0), layer2(0), ecal(0), hcal(0), vfcal(0), hcalexit(0), hoentr(0), prop(false),
-  closestDaughterId_(-1), momentum_(p->momentum()),
-  properDecayTime(dt)
+  closestDaughterId_(-1), species_(species), properDecayTime(dt)
 { 
   setTrackId(id);
-  info_ = mom_->theTable()->particle(HepPDT::ParticleID(type()));
 }
 
 FSimTrack::~FSimTrack() {;}
@@ -50,54 +48,74 @@ FSimTrack::setPropagate() {
   prop=true; 
 }
 
+/// Store the particle state at a given surface
+void 
+FSimTrack::setSurfaceState(FSimSurfaceTable::Surface s, const RawParticle& pp) { 
+  if ( id_ >= 0 ) mom_->theSurfaceTable->set(id_,s,pp);
+}
+
 /// Set the preshower layer1 variables
 void 
 FSimTrack::setLayer1(const RawParticle& pp, int success) { 
-  Layer1_Entrance=pp; 
+  setSurfaceState(FSimSurfaceTable::LAYER1,pp); 
   layer1=success; 
 }
 
 /// Set the preshower layer2 variables
 void 
 FSimTrack::setLayer2(const RawParticle& pp, int success) { 
-  Layer2_Entrance=pp; 
+  setSurfaceState(FSimSurfaceTable::LAYER2,pp); 
   layer2=success; 
 }
 
 /// Set the ecal variables
 void 
 FSimTrack::setEcal(const RawParticle& pp, int success) { 
-  ECAL_Entrance=pp; 
+  setSurfaceState(FSimSurfaceTable::ECAL,pp); 
   ecal=success; 
 }
 
 /// Set the hcal variables
 void 
 FSimTrack::setHcal(const RawParticle& pp, int success) { 
-  HCAL_Entrance=pp; 
+  setSurfaceState(FSimSurfaceTable::HCAL,pp); 
   hcal=success; 
 }
 
 /// Set the vcal variables
 void 
 FSimTrack::setVFcal(const RawParticle& pp, int success) { 
-  VFCAL_Entrance=pp; 
+  setSurfaceState(FSimSurfaceTable::VFCAL,pp); 
   vfcal=success; 
 }
 
 /// Set the hcal variables
 void 
 FSimTrack::setHcalExit(const RawParticle& pp, int success) { 
-  HCAL_Exit=pp; 
+  setSurfaceState(FSimSurfaceTable::HCALEXIT,pp); 
   hcalexit=success; 
 }
 
 void 
 FSimTrack::setHO(const RawParticle& pp, int success) { 
-  HO_Entrance=pp; 
+  setSurfaceState(FSimSurfaceTable::HO,pp); 
   hoentr=success; 
 }
 
+void 
+FSimTrack::setSurface(FSimSurfaceTable::Surface s, const RawParticle& pp, int success) { 
+  switch ( s ) { 
+  case FSimSurfaceTable::LAYER1 :   setLayer1(pp,success);   break;
+  case FSimSurfaceTable::LAYER2 :   setLayer2(pp,success);   break;
+  case FSimSurfaceTable::ECAL :     setEcal(pp,success);     break;
+  case FSimSurfaceTable::HCAL :     setHcal(pp,success);     break;
+  case FSimSurfaceTable::VFCAL :    setVFcal(pp,success);    break;
+  case FSimSurfaceTable::HCALEXIT : setHcalExit(pp,success); break;
+  case FSimSurfaceTable::HO :       setHO(pp,success);       break;
+  default : break;
+  }
+}
+
 
 
 
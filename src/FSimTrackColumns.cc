@@ -0,0 +1,60 @@
+#include "FastSimulation/Event/interface/FSimTrackColumns.h"
+
+const math::XYZTLorentzVector FSimTrackColumns::nullMomentum;
+
+FSimTrackColumns::FSimTrackColumns() : nAllocations_(0) {;}
+
+void
+FSimTrackColumns::reserve(unsigned n) {
+  if ( n <= capacity() ) return;
+  momentum_.reserve(n);
+  type_.reserve(n);
+  charge_.reserve(n);
+  vertex_.reserve(n);
+  endVertex_.reserve(n);
+  genpart_.reserve(n);
+  ++nAllocations_;
+}
+
+void
+FSimTrackColumns::release(unsigned n) {
+  std::vector<math::XYZTLorentzVector>().swap(momentum_);
+  std::vector<int>().swap(type_);
+  std::vector<float>().swap(charge_);
+  std::vector<int>().swap(vertex_);
+  std::vector<int>().swap(endVertex_);
+  std::vector<int>().swap(genpart_);
+  reserve(n);
+}
+
+unsigned long
+FSimTrackColumns::memory() const {
+  return 
+    momentum_.capacity()*sizeof(math::XYZTLorentzVector) +
+    charge_.capacity()*sizeof(float) +
+    ( type_.capacity() + vertex_.capacity() + 
+      endVertex_.capacity() + genpart_.capacity() ) * sizeof(int);
+}
+
+void
+FSimTrackColumns::clear() {
+  momentum_.clear();
+  type_.clear();
+  charge_.clear();
+  vertex_.clear();
+  endVertex_.clear();
+  genpart_.clear();
+}
+
+void
+FSimTrackColumns::add(const math::XYZTLorentzVector& p,
+		      int type, float charge, int iv, int ig) {
+  // All columns grow together
+  if ( size() == capacity() ) reserve(size() ? 2*size() : 1);
+  momentum_.push_back(p);
+  type_.push_back(type);
+  charge_.push_back(charge);
+  vertex_.push_back(iv);
+  endVertex_.push_back(-1);
+  genpart_.push_back(ig);
+}
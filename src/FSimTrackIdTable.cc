@@ -0,0 +1,74 @@
+//CMSSW Headers
+#include "SimDataFormats/Track/interface/SimTrack.h"
+
+//Famos Headers
+#include "FastSimulation/Event/interface/FSimTrackIdTable.h"
+
+FSimTrackIdTable::FSimTrackIdTable() :
+  dense_(true),
+  bits_(1),
+  nAllocations_(0)
+{;}
+
+void
+FSimTrackIdTable::fill(const std::vector<SimTrack>& simTracks) {
+
+  const unsigned n = simTracks.size();
+  unsigned maxId = 0;
+  for ( unsigned it=0; it<n; ++it )
+    if ( simTracks[it].trackId() > maxId ) maxId = simTracks[it].trackId();
+
+  // Dense ids : direct indexing
+  dense_ = maxId < 4*n + 64;
+  if ( dense_ ) {
+    if ( maxId+1 > direct_.capacity() ) ++nAllocations_;
+    direct_.assign(maxId+1,-1);
+    for ( unsigned it=0; it<n; ++it )
+      direct_[simTracks[it].trackId()] = it;
+    return;
+  }
+
+  // Sparse ids : hash table, at most half full
+  bits_ = 1;
+  while ( (1U << bits_) < 2*n ) ++bits_;
+  unsigned size = 1U << bits_;
+  if ( size > values_.capacity() ) ++nAllocations_;
+  keys_.resize(size);
+  values_.assign(size,-1);
+  const unsigned mask = size-1;
+  for ( unsigned it=0; it<n; ++it ) {
+    unsigned id = simTracks[it].trackId();
+    unsigned k = slot(id);
+    while ( values_[k] >= 0 && keys_[k] != id ) k = (k+1) & mask;
+    keys_[k] = id;
+    values_[k] = it;
+  }
+
+}
+
+int
+FSimTrackIdTable::findHashed(unsigned trackId) const {
+  if ( values_.empty() ) return -1;
+  const unsigned mask = values_.size()-1;
+  unsigned k = slot(trackId);
+  while ( values_[k] >= 0 ) {
+    if ( keys_[k] == trackId ) return values_[k];
+    k = (k+1) & mask;
+  }
+  return -1;
+}
+
+void
+FSimTrackIdTable::release() {
+  std::vector<int>().swap(direct_);
+  std::vector<unsigned>().swap(keys_);
+  std::vector<int>().swap(values_);
+  dense_ = true;
+}
+
+unsigned long
+FSimTrackIdTable::memory() const {
+  return
+    ( direct_.capacity() + values_.capacity() ) * sizeof(int) +
+    keys_.capacity() * sizeof(unsigned);
+}
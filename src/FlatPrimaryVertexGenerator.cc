@@ -22,8 +22,24 @@ FlatPrimaryVertexGenerator::FlatPrimaryVertexGenerator(
 void
 FlatPrimaryVertexGenerator::generate() {
 
+  if ( generateFromStream() ) return;
+
   this->SetX(random->flatShoot(minX,maxX));
   this->SetY(random->flatShoot(minY,maxY));
   this->SetZ(random->flatShoot(minZ,maxZ));
 
 }
+
+void
+FlatPrimaryVertexGenerator::generateBatch(unsigned n, Batch& out) {
+
+  out.resize(n);
+  const double* u = flats(n,3);
+  for ( unsigned i=0; i<n; ++i ) {
+    out.x[i] = minX + (maxX-minX) * u[i];
+    out.y[i] = minY + (maxY-minY) * u[n+i];
+    out.z[i] = minZ + (maxZ-minZ) * u[2*n+i];
+    out.t[i] = 0.;
+  }
+
+}
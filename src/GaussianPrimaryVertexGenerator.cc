@@ -22,8 +22,24 @@ GaussianPrimaryVertexGenerator::GaussianPrimaryVertexGenerator(
 void
 GaussianPrimaryVertexGenerator::generate() {
 
+  if ( generateFromStream() ) return;
+
   this->SetX(random->gaussShoot(meanX,sigmaX));
   this->SetY(random->gaussShoot(meanY,sigmaY));
   this->SetZ(random->gaussShoot(meanZ,sigmaZ));
 
 }
+
+void
+GaussianPrimaryVertexGenerator::generateBatch(unsigned n, Batch& out) {
+
+  out.resize(n);
+  const double* g = gaussians(n,3);
+  for ( unsigned i=0; i<n; ++i ) {
+    out.x[i] = meanX + sigmaX * g[i];
+    out.y[i] = meanY + sigmaY * g[n+i];
+    out.z[i] = meanZ + sigmaZ * g[2*n+i];
+    out.t[i] = 0.;
+  }
+
+}
@@ -2,12 +2,28 @@
 
 //Framework Headers
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/MessageLogger/interface/MessageLogger.h"
 
+// TBB
+#include "tbb/enumerable_thread_specific.h"
+
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include <iterator>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+// The counts, for each thread (low overhead: one TLS key per filter)
+class KineParticleFilter::ThreadCounters : 
+  public tbb::enumerable_thread_specific<KineParticleFilter::Counters,
+					 tbb::cache_aligned_allocator<KineParticleFilter::Counters>,
+					 tbb::ets_key_per_instance> {};
 
 KineParticleFilter::KineParticleFilter(const edm::ParameterSet& kine) 
-  : BaseRawParticleFilter() 
+  : BaseRawParticleFilter(),
+    threadCounters(new ThreadCounters())
 {
 
   // Set the kinematic cuts
@@ -19,6 +35,8 @@ KineParticleFilter::KineParticleFilter(const edm::ParameterSet& kine)
   EMin   = kine.getParameter<double>("EMin");
   // Lower E  bound - accept (all, in GeV)
   EMax   = kine.getParameter<double>("EProton");
+  // Print the numbers of rejected particles at the end
+  printSummary = kine.getUntrackedParameter<bool>("printRejectionSummary",false);
 
   // pdg codes of the particles to be removed from the events
   // ParameterSet cannot handle sets, only vectors
@@ -26,17 +44,27 @@ KineParticleFilter::KineParticleFilter(const edm::ParameterSet& kine)
     = kine.getUntrackedParameter< std::vector<int> >
     ("forbiddenPdgCodes", std::vector<int>() );
   
-  std::copy(tmpcodes.begin(), 
-	    tmpcodes.end(),  
-	    std::insert_iterator< std::set<int> >(forbiddenPdgCodes,
-						  forbiddenPdgCodes.begin() ));
-  
-  if( !forbiddenPdgCodes.empty() ) {
+  if( !tmpcodes.empty() ) {
     std::cout<<"KineParticleFilter : Forbidden PDG codes : ";
-    copy(forbiddenPdgCodes.begin(), forbiddenPdgCodes.end(), 
+    copy(tmpcodes.begin(), tmpcodes.end(), 
 	 std::ostream_iterator<int>(std::cout, " "));
   }  
 
+  // Classify the species once for all: do not consider quarks, gluons, 
+  // Z, W, strings, diquarks ... and supersymmetric particles, nor the 
+  // forbidden codes
+  speciesTable.resize(NSPECIES);
+  for ( int pId=1; pId<NSPECIES; ++pId ) 
+    speciesTable[pId] = ( simulable(pId) ? SIMULABLE : 0 ) | ALLOWED;
+  for ( unsigned ic=0; ic<tmpcodes.size(); ++ic ) { 
+    if ( tmpcodes[ic] <= 0 ) continue;
+    if ( tmpcodes[ic] < NSPECIES ) 
+      speciesTable[tmpcodes[ic]] &= ~ALLOWED;
+    else
+      forbiddenExoticCodes.push_back(tmpcodes[ic]);
+  }
+  std::sort(forbiddenExoticCodes.begin(),forbiddenExoticCodes.end());
+
   // Change eta cuts to cos**2(theta) cuts (less CPU consuming)
   if ( etaMax > 20. ) etaMax = 20.; // Protection against paranoid people.
   double cosMax = (std::exp(2.*etaMax)-1.) / (std::exp(2.*etaMax)+1.);
@@ -54,7 +82,56 @@ KineParticleFilter::KineParticleFilter(const edm::ParameterSet& kine)
 
 }
 
+bool KineParticleFilter::simulable(int pId)
+{
+  return ( pId > 10  && pId != 12 && pId != 14 && 
+	   pId != 16 && pId != 18 && pId != 21 &&
+	   (pId < 23 || pId > 40  ) &&
+	   (pId < 81 || pId > 100 ) && pId != 2101 &&
+	   pId != 3101 && pId != 3201 && pId != 1103 &&
+	   pId != 2103 && pId != 2203 && pId != 3103 &&
+	   pId != 3203 && pId != 3303 );
+}
+
+KineParticleFilter::~KineParticleFilter()
+{
+  delete threadCounters;
+}
+
+void KineParticleFilter::endJob() const
+{
+  if ( !printSummary ) return;
+  std::ostringstream summary;
+  printCounters(summary);
+  edm::LogInfo("KineParticleFilter") << summary.str();
+}
+
+unsigned KineParticleFilter::exoticSpecies(int pId) const
+{
+  return std::binary_search(forbiddenExoticCodes.begin(),
+			    forbiddenExoticCodes.end(),pId) ? 
+    SIMULABLE : SIMULABLE | ALLOWED;
+}
+
 bool KineParticleFilter::isOKForMe(const RawParticle* p) const
+{
+
+  Rejection r = rejection(p);
+
+  // The counts of this thread, only if they are to be reported
+  if ( printSummary ) { 
+    Counters& counts = threadCounters->local();
+    if ( p->pid() != 0 ) ++counts.nParticles;
+    else ++counts.nVertices;
+    if ( r != NREJECTIONS ) ++counts.rejected[r];
+  }
+
+  return r == NREJECTIONS;
+
+}
+
+KineParticleFilter::Rejection 
+KineParticleFilter::rejection(const RawParticle* p) const
 {
 
   // Do not consider quarks, gluons, Z, W, strings, diquarks
@@ -63,34 +140,24 @@ bool KineParticleFilter::isOKForMe(const RawParticle* p) const
 
   // Vertices are coming with pId = 0
   if ( pId != 0 ) { 
-    bool particleCut = ( pId > 10  && pId != 12 && pId != 14 && 
-			 pId != 16 && pId != 18 && pId != 21 &&
-			 (pId < 23 || pId > 40  ) &&
-			 (pId < 81 || pId > 100 ) && pId != 2101 &&
-			 pId != 3101 && pId != 3201 && pId != 1103 &&
-			 pId != 2103 && pId != 2203 && pId != 3103 &&
-			 pId != 3203 && pId != 3303 );
-    //    particleCut = particleCut || pId == 0;
-
-
-    if ( !particleCut ) return false;
+    const unsigned type = species(pId);
+    if ( !(type & SIMULABLE) ) return SPECIES;
 
     // Keep protons with energy in excess of 5 TeV
     bool protonTaggers =  (pId == 2212 && p->E() >= EMax) ;
-    if ( protonTaggers ) return true;
+    if ( protonTaggers ) return NREJECTIONS;
 
-    std::set<int>::iterator is = forbiddenPdgCodes.find(pId);
-    if( is != forbiddenPdgCodes.end() ) return false;
+    if ( !(type & ALLOWED) ) return FORBIDDEN;
 
   //  bool kineCut = pId == 0;
   // Cut on kinematic properties
     // Cut on the energy of all particles
     bool eneCut = p->E() >= EMin;
-    if (!eneCut) return false;
+    if (!eneCut) return ENERGY;
 
     // Cut on the transverse momentum of charged particles
     bool pTCut = p->charge()==0 || p->Perp2()>=pTMin;
-    if (!pTCut) return false;
+    if (!pTCut) return PT;
 
     // Cut on eta if the origin vertex is close to the beam
     //    bool etaCut = (p->vertex()-mainVertex).perp()>5. || fabs(p->eta())<=etaMax;
@@ -104,7 +171,7 @@ bool KineParticleFilter::isOKForMe(const RawParticle* p) const
 	   << (p->eta()) << " " << etaMax << " " 
 	   << p->vect().cos2Theta() << " " << cos2Max << endl; 
     */
-    if (!etaCut) return false;
+    if (!etaCut) return ETA;
 
     // Cut on the origin vertex position (prior to the ECAL for all 
     // particles, except for muons  ! Just modified: Muons included as well !
@@ -116,7 +183,7 @@ bool KineParticleFilter::isOKForMe(const RawParticle* p) const
 		     (cos2Tet>cos2PreshMin && cos2Tet<cos2PreshMax 
 		      && radius2<171.11*171.11 && zed<317.01) );
 
-    return ecalAcc;
+    return ecalAcc ? NREJECTIONS : ORIGIN;
 
   } else { 
     // Cut for vertices
@@ -129,8 +196,159 @@ bool KineParticleFilter::isOKForMe(const RawParticle* p) const
 		     (cos2Tet>cos2PreshMin && cos2Tet<cos2PreshMax 
 		      && radius2<171.11*171.11 && zed<317.01) );
 
-    return ecalAcc;
+    return ecalAcc ? NREJECTIONS : VERTEX;
+
+  }
+
+}
+
+unsigned KineParticleFilter::acceptBatch(unsigned n,
+					 const double* px, const double* py, 
+					 const double* pz, const double* e,
+					 const double* x, const double* y, 
+					 const double* z,
+					 const int* pdgId, const double* charge, 
+					 int* mask) const
+{
+
+  // The species first (a table lookup for each particle)
+  for ( unsigned i=0; i<n; ++i ) { 
+    int pId = pdgId[i] < 0 ? -pdgId[i] : pdgId[i];
+    mask[i] = pId ? species(pId) : 0;
+  }
+
+  // Then the kinematic and origin vertex cuts, without branches
+  const double mvx = mainVertex.X();
+  const double mvy = mainVertex.Y();
+  const double ecalR2 = 129.01*129.01;
+  const double preshR2 = 171.11*171.11;
+  unsigned nAccepted = 0;
+  unsigned long nParticles = 0, nSpecies = 0, nForbidden = 0, nEnergy = 0;
+  unsigned long nPt = 0, nEta = 0, nOrigin = 0;
+  for ( unsigned i=0; i<n; ++i ) { 
+
+    const double pt2 = px[i]*px[i] + py[i]*py[i];
+    const double p2 = pt2 + pz[i]*pz[i];
+    const double dx = x[i] - mvx;
+    const double dy = y[i] - mvy;
+    const double r2 = x[i]*x[i] + y[i]*y[i];
+    const double zed = std::fabs(z[i]);
+    const double cos2Tet = z[i]*z[i] / (r2 + z[i]*z[i]);
+
+    const int protonTaggers = ( pdgId[i] == 2212 || pdgId[i] == -2212 ) & ( e[i] >= EMax );
+    const int eneCut = e[i] >= EMin;
+    const int pTCut = ( charge[i] == 0. ) | ( pt2 >= pTMin );
+    const int etaCut = ( dx*dx + dy*dy > 25. ) | ( pz[i]*pz[i]/p2 <= cos2Max );
+    const int ecalAcc = 
+      ( ( r2 < ecalR2 ) & ( zed < 317.01 ) ) |
+      ( ( cos2Tet > cos2PreshMin ) & ( cos2Tet < cos2PreshMax ) & 
+	( r2 < preshR2 ) & ( zed < 317.01 ) );
+
+    // The cuts in the order of accept(), for the counts (the padding
+    // entries, with pdgId 0, are not counted)
+    const int real = pdgId[i] != 0;
+    const int simulated = ( mask[i] & SIMULABLE ) != 0;
+    const int allowed = ( mask[i] & ALLOWED ) != 0;
+    const int passSpecies = simulated & !protonTaggers;
+    const int passForbidden = passSpecies & allowed;
+    const int passEnergy = passForbidden & eneCut;
+    const int passPt = passEnergy & pTCut;
+    const int passEta = passPt & etaCut;
+    nParticles += real;
+    nSpecies += real & !simulated;
+    nForbidden += passSpecies & !allowed;
+    nEnergy += passForbidden & !eneCut;
+    nPt += passEnergy & !pTCut;
+    nEta += passPt & !etaCut;
+    nOrigin += passEta & !ecalAcc;
+
+    const int accepted = ( simulated & protonTaggers ) | ( passEta & ecalAcc );
+    mask[i] = accepted;
+    nAccepted += accepted;
+
+  }
+
+  // The counts of this thread, only if they are to be reported
+  if ( printSummary ) { 
+    Counters& counts = threadCounters->local();
+    counts.nParticles += nParticles;
+    counts.rejected[SPECIES] += nSpecies;
+    counts.rejected[FORBIDDEN] += nForbidden;
+    counts.rejected[ENERGY] += nEnergy;
+    counts.rejected[PT] += nPt;
+    counts.rejected[ETA] += nEta;
+    counts.rejected[ORIGIN] += nOrigin;
+  }
+
+  return nAccepted;
+
+}
+
+KineParticleFilter::Counters::Counters() : nParticles(0), nVertices(0)
+{
+  for ( unsigned r=0; r<NREJECTIONS; ++r ) rejected[r] = 0;
+}
+
+KineParticleFilter::Counters& 
+KineParticleFilter::Counters::operator+=(const Counters& c)
+{
+  nParticles += c.nParticles;
+  nVertices += c.nVertices;
+  for ( unsigned r=0; r<NREJECTIONS; ++r ) rejected[r] += c.rejected[r];
+  return *this;
+}
+
+KineParticleFilter::Counters KineParticleFilter::counters() const
+{
+  Counters sum;
+  const ThreadCounters& all = *threadCounters;
+  ThreadCounters::const_iterator counts;
+  for ( counts=all.begin(); counts!=all.end(); ++counts ) 
+    sum += *counts;
+  return sum;
+}
+
+const char* KineParticleFilter::name(Rejection r)
+{
+  switch ( r ) { 
+  case SPECIES :   return "Species not simulated";
+  case FORBIDDEN : return "Forbidden PDG code";
+  case ENERGY :    return "E < EMin";
+  case PT :        return "pT < pTMin (charged)";
+  case ETA :       return "|eta| > etaMax";
+  case ORIGIN :    return "Origin beyond ECAL entrance";
+  case VERTEX :    return "Vertex beyond ECAL entrance";
+  default : return "";
+  }
+}
+
+void KineParticleFilter::printCounters(std::ostream& out) const
+{
+
+  Counters sum = counters();
+  std::ios::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+  unsigned long nRejected = 0;
+  for ( unsigned r=0; r<VERTEX; ++r ) nRejected += sum.rejected[r];
 
+  out << "KineParticleFilter : rejected particles and vertices" << std::endl
+      << std::setw(30) << std::left << "Particles tested" 
+      << std::setw(12) << std::right << sum.nParticles << std::endl;
+  for ( unsigned r=0; r<NREJECTIONS; ++r ) { 
+    if ( r == VERTEX ) 
+      out << std::setw(30) << std::left << "Particles accepted" 
+	  << std::setw(12) << std::right << sum.nParticles-nRejected << std::endl
+	  << std::setw(30) << std::left << "Vertices tested" 
+	  << std::setw(12) << std::right << sum.nVertices << std::endl;
+    unsigned long n = r == VERTEX ? sum.nVertices : sum.nParticles;
+    out << std::setw(30) << std::left << name((Rejection)r) 
+	<< std::setw(12) << std::right << sum.rejected[r] 
+	<< std::setw(10) << std::fixed << std::setprecision(2)
+	<< ( n ? 100.*sum.rejected[r]/n : 0. ) << " %" << std::endl;
   }
+  out << std::setw(30) << std::left << "Vertices accepted" 
+      << std::setw(12) << std::right << sum.nVertices-sum.rejected[VERTEX] << std::endl;
+  out.flags(flags);
+  out.precision(precision);
 
 }
@@ -1,30 +1,145 @@
 #include "FastSimulation/Event/interface/PrimaryVertexGenerator.h"
+#include "FastSimulation/Event/interface/CounterBasedRandom.h"
+#include "FastSimulation/Utilities/interface/RandomEngine.h"
+
+#include "TMatrixD.h"
+
+#include <cmath>
 
   /// Default constructor
 PrimaryVertexGenerator::PrimaryVertexGenerator() : 
   math::XYZVector(), 
   random(0),
-  boost_(0)
+  time_(0.),
+  boosted_(false),
+  rootBoost_(0),
+  counterBased_(0),
+  interaction_(0)
 {
 }
 
 PrimaryVertexGenerator::PrimaryVertexGenerator(const RandomEngine* engine) : 
   math::XYZVector(), 
   random(engine),
-  boost_(0)
+  time_(0.),
+  boosted_(false),
+  rootBoost_(0),
+  counterBased_(0),
+  interaction_(0)
 {
 }
 
 PrimaryVertexGenerator::~PrimaryVertexGenerator() { 
-  if ( boost_ ) delete boost_; 
+  delete rootBoost_; 
+  delete counterBased_;
+}
+
+void 
+PrimaryVertexGenerator::setCounterBasedSeed(unsigned seed) { 
+  delete counterBased_;
+  counterBased_ = new CounterBasedRandom(seed);
+  interaction_ = 0;
+}
+
+void 
+PrimaryVertexGenerator::setEvent(unsigned run, unsigned lumi, unsigned long long event) { 
+  if ( !counterBased_ ) return;
+  counterBased_->setEvent(run,lumi,event);
+  interaction_ = 0;
 }
 
 TMatrixD* 
 PrimaryVertexGenerator::boost() const { 
-  return boost_;
+  return rootBoost_;
 }
 
 void 
-PrimaryVertexGenerator::setBoost(TMatrixD* aBoost) {
+PrimaryVertexGenerator::setBoost(const CrossingAngleBoost& aBoost) {
   boost_ = aBoost;
+  boosted_ = true;
+  if ( !rootBoost_ ) rootBoost_ = new TMatrixD(4,4);
+  for ( unsigned i=0; i<4; ++i ) 
+    for ( unsigned j=0; j<4; ++j ) 
+      (*rootBoost_)(i,j) = boost_(i,j);
+}
+
+void 
+PrimaryVertexGenerator::applyBoost(unsigned n, double* x, double* y, double* z, double* t) const { 
+  if ( boosted_ ) boost_.apply(n,x,y,z,t);
+}
+
+void
+PrimaryVertexGenerator::generateBatch(unsigned n, Batch& out) { 
+
+  math::XYZVector last(*this);
+  double lastTime = time_;
+  out.resize(n);
+  for ( unsigned i=0; i<n; ++i ) { 
+    generate();
+    out.x[i] = X();
+    out.y[i] = Y();
+    out.z[i] = Z();
+    out.t[i] = time_;
+  }
+  math::XYZVector::operator=(last);
+  time_ = lastTime;
+
+}
+
+const double*
+PrimaryVertexGenerator::flats(unsigned nVertices, unsigned nPerVertex) { 
+
+  unsigned n = nVertices*nPerVertex;
+  flats_.resize(n);
+  if ( !counterBased_ ) { 
+    for ( unsigned i=0; i<n; ++i ) flats_[i] = 1.-random->flatShoot();
+  } else { 
+    // Two numbers per block of the stream of each interaction
+    for ( unsigned k=0; k<nPerVertex; k+=2 ) { 
+      double* u0 = &flats_[k*nVertices];
+      double* u1 = k+1 < nPerVertex ? u0+nVertices : 0;
+      for ( unsigned i=0; i<nVertices; ++i ) { 
+	double u;
+	counterBased_->flats(interaction_+i,k/2,u0[i],u);
+	if ( u1 ) u1[i] = u;
+      }
+    }
+    interaction_ += nVertices;
+  }
+  return n ? &flats_[0] : 0;
+
+}
+
+const double*
+PrimaryVertexGenerator::gaussians(unsigned nVertices, unsigned nPerVertex) { 
+
+  // Box-Muller, from pairs of flat random numbers of each vertex
+  unsigned nPairs = (nPerVertex+1)/2;
+  const double* u = flats(nVertices,2*nPairs);
+  gaussians_.resize(2*nPairs*nVertices);
+  for ( unsigned k=0; k<nPairs; ++k ) { 
+    const double* u0 = u + 2*k*nVertices;
+    const double* u1 = u0 + nVertices;
+    double* g0 = &gaussians_[2*k*nVertices];
+    double* g1 = g0 + nVertices;
+    for ( unsigned i=0; i<nVertices; ++i ) { 
+      double r = std::sqrt(-2.*std::log(u0[i]));
+      double phi = 2.*M_PI*u1[i];
+      g0[i] = r*std::cos(phi);
+      g1[i] = r*std::sin(phi);
+    }
+  }
+  return nVertices ? &gaussians_[0] : 0;
+
+}
+
+bool
+PrimaryVertexGenerator::generateFromStream() { 
+
+  if ( !counterBased_ ) return false;
+  generateBatch(1,one_);
+  SetXYZ(one_.x[0],one_.y[0],one_.z[0]);
+  time_ = one_.t[0];
+  return true;
+
 }
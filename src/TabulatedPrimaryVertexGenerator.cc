@@ -0,0 +1,113 @@
+//Framework Headers
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+//Famos Headers
+#include "FastSimulation/Event/interface/TabulatedPrimaryVertexGenerator.h"
+#include "FastSimulation/Utilities/interface/RandomEngine.h"
+
+#include <cmath>
+
+TabulatedPrimaryVertexGenerator::TabulatedPrimaryVertexGenerator(
+  const edm::ParameterSet& vtx, const RandomEngine* engine) : 
+  PrimaryVertexGenerator(engine),
+  edgesX_(vtx.getParameter< std::vector<double> >("BinEdgesX")),
+  edgesY_(vtx.getParameter< std::vector<double> >("BinEdgesY")),
+  edgesZ_(vtx.getParameter< std::vector<double> >("BinEdgesZ")),
+  nx_(edgesX_.size() > 1 ? edgesX_.size()-1 : 0),
+  ny_(edgesY_.size() > 1 ? edgesY_.size()-1 : 0),
+  nz_(edgesZ_.size() > 1 ? edgesZ_.size()-1 : 0)
+{
+
+  // The bin contents, x running fastest, then y, then z
+  std::vector<double> contents = vtx.getParameter< std::vector<double> >("Contents");
+  if ( !nx_ || !ny_ || !nz_ || contents.size() != nx_*ny_*nz_ )
+    throw cms::Exception("TabulatedPrimaryVertexGenerator") 
+      << "The vertex profile has " << contents.size() << " bins instead of " 
+      << nx_ << "x" << ny_ << "x" << nz_ << "\n";
+
+  // The bin edges must increase strictly (NaN's fail too), and the 
+  // contents be finite and positive or zero
+  const std::vector<double>* edges[3] = { &edgesX_, &edgesY_, &edgesZ_ };
+  const char* axis[3] = { "X", "Y", "Z" };
+  for ( unsigned a=0; a<3; ++a ) 
+    for ( unsigned i=0; i+1<edges[a]->size(); ++i ) 
+      if ( !( (*edges[a])[i+1] > (*edges[a])[i] ) )
+	throw cms::Exception("TabulatedPrimaryVertexGenerator") 
+	  << "The bin edges " << axis[a] << " do not increase: " 
+	  << (*edges[a])[i] << " then " << (*edges[a])[i+1] << "\n";
+  for ( unsigned bin=0; bin<contents.size(); ++bin ) 
+    if ( !std::isfinite(contents[bin]) || contents[bin] < 0. )
+      throw cms::Exception("TabulatedPrimaryVertexGenerator") 
+	<< "The content of bin " << bin << " is " << contents[bin] << "\n";
+
+  // The non-empty bins, and the mean vertex (the beam spot)
+  double sum = 0., sumX = 0., sumY = 0., sumZ = 0.;
+  for ( unsigned bin=0; bin<contents.size(); ++bin ) { 
+    if ( contents[bin] == 0. ) continue;
+    unsigned ix = bin % nx_;
+    unsigned iy = (bin / nx_) % ny_;
+    unsigned iz = bin / (nx_*ny_);
+    bin_.push_back(bin);
+    sum += contents[bin];
+    sumX += contents[bin] * (edgesX_[ix]+edgesX_[ix+1])/2.;
+    sumY += contents[bin] * (edgesY_[iy]+edgesY_[iy+1])/2.;
+    sumZ += contents[bin] * (edgesZ_[iz]+edgesZ_[iz+1])/2.;
+  }
+  if ( bin_.empty() ) 
+    throw cms::Exception("TabulatedPrimaryVertexGenerator") 
+      << "The vertex profile is empty\n";
+  beamSpot_ = math::XYZPoint(sumX/sum,sumY/sum,sumZ/sum);
+
+  // The alias table (Vose): the columns with less than the average
+  // probability are completed with the ones with more
+  const unsigned n = bin_.size();
+  prob_.resize(n);
+  alias_.resize(n);
+  std::vector<unsigned> small, large;
+  for ( unsigned k=0; k<n; ++k ) { 
+    prob_[k] = contents[bin_[k]] * n / sum;
+    alias_[k] = k;
+    if ( prob_[k] < 1. ) small.push_back(k);
+    else large.push_back(k);
+  }
+  while ( !small.empty() && !large.empty() ) { 
+    unsigned s = small.back(); small.pop_back();
+    unsigned l = large.back();
+    alias_[s] = l;
+    prob_[l] -= 1. - prob_[s];
+    if ( prob_[l] < 1. ) { 
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // What is left is full, up to the rounding errors
+  for ( unsigned k=0; k<small.size(); ++k ) prob_[small[k]] = 1.;
+  for ( unsigned k=0; k<large.size(); ++k ) prob_[large[k]] = 1.;
+
+}
+
+void
+TabulatedPrimaryVertexGenerator::generate() {
+
+  if ( generateFromStream() ) return;
+
+  double u[4];
+  for ( unsigned k=0; k<4; ++k ) u[k] = 1.-random->flatShoot();
+  double x, y, z;
+  sample(u[0],u[1],u[2],u[3],x,y,z);
+  this->SetXYZ(x,y,z);
+
+}
+
+void
+TabulatedPrimaryVertexGenerator::generateBatch(unsigned n, Batch& out) {
+
+  out.resize(n);
+  const double* u = flats(n,4);
+  for ( unsigned i=0; i<n; ++i ) {
+    sample(u[i],u[n+i],u[2*n+i],u[3*n+i],out.x[i],out.y[i],out.z[i]);
+    out.t[i] = 0.;
+  }
+
+}
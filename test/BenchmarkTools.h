@@ -0,0 +1,129 @@
+#ifndef FastSimulation_Event_BenchmarkTools_H
+#define FastSimulation_Event_BenchmarkTools_H
+
+// CMSSW Headers
+#include "FWCore/ParameterSet/interface/ParameterSet.h"
+
+// HepPDT
+#include "HepPDT/TableBuilder.hh"
+#include "SimGeneral/HepPDTRecord/interface/ParticleDataTable.h"
+
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+/** The tools shared by the standalone benchmarks of this package: a
+ *  wall clock, the peak resident set size, a count of the heap
+ *  allocations (global operator new is replaced: include this header
+ *  in the main file of an executable only), the default parameters of
+ *  the particle filter and of the vertex generators, and a minimal 
+ *  particle data table for the species of SyntheticEvents.h.
+ */
+
+namespace BenchmarkTools {
+
+  /// The number of heap allocations since the start (counted from all 
+  /// the threads, e.g. those of the parallel propagation)
+  inline std::atomic<unsigned long>& nHeapAllocations() {
+    static std::atomic<unsigned long> n(0);
+    return n;
+  }
+
+  /// The wall clock, in s
+  inline double now() {
+    timeval t;
+    gettimeofday(&t,0);
+    return t.tv_sec + 1E-6*t.tv_usec;
+  }
+
+  /// The peak resident set size, in MB
+  inline double peakRSS() {
+    rusage usage;
+    getrusage(RUSAGE_SELF,&usage);
+    return usage.ru_maxrss/1024.;
+  }
+
+  /// The default cuts of the particle filter (ParticleFilter_cfi.py)
+  inline edm::ParameterSet particleFilter() {
+    edm::ParameterSet kine;
+    kine.addParameter<double>("EProton",5000.);
+    kine.addParameter<double>("etaMax",5.1);
+    kine.addParameter<double>("pTMin",0.2);
+    kine.addParameter<double>("EMin",0.1);
+    return kine;
+  }
+
+  /// The vertex smearing parameters of all the types 
+  /// (VtxSmearedParameters_cfi.py)
+  inline edm::ParameterSet vertexGenerator(const std::string& type) {
+    edm::ParameterSet vtx;
+    vtx.addParameter<std::string>("type",type);
+    vtx.addParameter<double>("MeanX",0.);
+    vtx.addParameter<double>("MeanY",0.);
+    vtx.addParameter<double>("MeanZ",0.);
+    vtx.addParameter<double>("SigmaX",0.0015);
+    vtx.addParameter<double>("SigmaY",0.0015);
+    vtx.addParameter<double>("SigmaZ",5.3);
+    vtx.addParameter<double>("MinX",-0.0015);
+    vtx.addParameter<double>("MinY",-0.0015);
+    vtx.addParameter<double>("MinZ",-5.3);
+    vtx.addParameter<double>("MaxX",0.0015);
+    vtx.addParameter<double>("MaxY",0.0015);
+    vtx.addParameter<double>("MaxZ",5.3);
+    vtx.addParameter<double>("X0",0.0322);
+    vtx.addParameter<double>("Y0",0.);
+    vtx.addParameter<double>("Z0",0.);
+    vtx.addParameter<double>("Alpha",0.);
+    vtx.addParameter<double>("Phi",0.);
+    vtx.addParameter<double>("BetaStar",55.);
+    vtx.addParameter<double>("Emittance",1.006e-07);
+    return vtx;
+  }
+
+  /// A particle and its antiparticle (lifetime in mm/c)
+  inline void addParticle(HepPDT::TableBuilder& tb, int id, const char* name,
+			  double mass, double charge, double lifetime) {
+    for ( int sign=1; sign>=-1; sign-=2 ) {
+      if ( sign < 0 && ( id == 22 || id == 111 || id == 130 || id == 310 ) ) break;
+      HepPDT::TempParticleData& p = tb.getParticleData(HepPDT::ParticleID(sign*id));
+      p.tempParticleName = sign > 0 ? name : std::string(name)+"~";
+      p.tempCharge = sign*charge;
+      p.tempMass = HepPDT::Measurement(mass,0.);
+      p.tempWidth = HepPDT::Measurement(lifetime > 0. ? 1.97327E-13/lifetime : 0.,0.);
+    }
+  }
+
+  /// The species of the synthetic events, and the leptons
+  inline void minimalTable(HepPDT::ParticleDataTable& pdt) {
+    HepPDT::TableBuilder tb(pdt);
+    addParticle(tb,   11, "e-",    0.000511, -1., 0.);
+    addParticle(tb,   12, "nu_e",  0.,        0., 0.);
+    addParticle(tb,   13, "mu-",   0.105658, -1., 658654.);
+    addParticle(tb,   14, "nu_mu", 0.,        0., 0.);
+    addParticle(tb,   22, "gamma", 0.,        0., 0.);
+    addParticle(tb,  111, "pi0",   0.134977,  0., 2.5E-5);
+    addParticle(tb,  211, "pi+",   0.139570,  1., 7804.5);
+    addParticle(tb,  130, "K_L0",  0.497614,  0., 15340.);
+    addParticle(tb,  310, "K_S0",  0.497614,  0., 26.84);
+    addParticle(tb,  321, "K+",    0.493677,  1., 3712.);
+    addParticle(tb, 2112, "n0",    0.939565,  0., 0.);
+    addParticle(tb, 2212, "p+",    0.938272,  1., 0.);
+  }
+
+}
+
+// Count the heap allocations
+void* operator new(std::size_t size) {
+  BenchmarkTools::nHeapAllocations().fetch_add(1,std::memory_order_relaxed);
+  void* p = std::malloc(size ? size : 1);
+  if ( !p ) throw std::bad_alloc();
+  return p;
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) throw() { std::free(p); }
+void operator delete[](void* p) throw() { std::free(p); }
+
+#endif // BenchmarkTools_H
@@ -0,0 +1,206 @@
+#ifndef FastSimulation_Event_SyntheticEvents_H
+#define FastSimulation_Event_SyntheticEvents_H
+
+// HepMC Headers
+#include "HepMC/GenEvent.h"
+#include "HepMC/GenVertex.h"
+#include "HepMC/GenParticle.h"
+
+// CMSSW Headers
+#include "DataFormats/HepMCCandidate/interface/GenParticle.h"
+#include "SimGeneral/HepPDTRecord/interface/ParticleDataTable.h"
+#include "SimDataFormats/Track/interface/SimTrackContainer.h"
+#include "SimDataFormats/Vertex/interface/SimVertexContainer.h"
+
+// FAMOS Headers
+#include "FastSimulation/Event/interface/FSimEvent.h"
+
+// ROOT
+#include "TRandom3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+/** Synthetic HepMC events, to exercise FBaseSimEvent without a generator.
+ *  Each event has two beam protons, and nParticles particles produced at
+ *  the origin with an exponential pT spectrum (mean 0.5 GeV/c) and flat
+ *  in eta (|eta|<6): 70% of charged pions, 10% of charged kaons, 5% of
+ *  protons, 10% of pi0's decaying promptly to two photons, and 5% of K0S's
+ *  decaying to two charged pions a few cm away. All distances in mm.
+ *  The same events are also given as reco::GenParticle's, and as the 
+ *  SimTrack's and SimVertex'ices of a filled FSimEvent.
+ */
+
+namespace SyntheticEvents {
+
+  /// A particle of this mass and momentum (flat in eta and phi)
+  inline HepMC::FourVector momentum(TRandom3& random, double mass, double ptMean) {
+    double pt = random.Exp(ptMean);
+    double eta = random.Uniform(-6.,6.);
+    double phi = random.Uniform(-M_PI,M_PI);
+    double px = pt*std::cos(phi);
+    double py = pt*std::sin(phi);
+    double pz = pt*std::sinh(eta);
+    return HepMC::FourVector(px,py,pz,std::sqrt(px*px+py*py+pz*pz+mass*mass));
+  }
+
+  /// A two-body decay, isotropic in the rest frame
+  inline void decay(TRandom3& random, const HepMC::FourVector& p, double mass,
+		    double m1, double m2,
+		    HepMC::FourVector& p1, HepMC::FourVector& p2) {
+    double e1 = (mass*mass + m1*m1 - m2*m2) / (2.*mass);
+    double q = std::sqrt(std::max(e1*e1-m1*m1,0.));
+    double cost = random.Uniform(-1.,1.);
+    double sint = std::sqrt(1.-cost*cost);
+    double phi = random.Uniform(-M_PI,M_PI);
+    double qx = q*sint*std::cos(phi);
+    double qy = q*sint*std::sin(phi);
+    double qz = q*cost;
+    // Boost to the lab frame
+    double bx = p.px()/p.e(), by = p.py()/p.e(), bz = p.pz()/p.e();
+    double b2 = bx*bx+by*by+bz*bz;
+    double gamma = 1./std::sqrt(1.-b2);
+    double bq = bx*qx+by*qy+bz*qz;
+    double g2 = b2 > 0. ? (gamma-1.)/b2 : 0.;
+    double f = g2*bq + gamma*e1;
+    p1 = HepMC::FourVector(qx+f*bx,qy+f*by,qz+f*bz,gamma*(e1+bq));
+    p2 = HepMC::FourVector(p.px()-p1.px(),p.py()-p1.py(),p.pz()-p1.pz(),p.e()-p1.e());
+  }
+
+  /// An event with nParticles particles (the caller owns it)
+  inline HepMC::GenEvent* genEvent(TRandom3& random, unsigned nParticles, int number=0) {
+
+    HepMC::GenEvent* event = new HepMC::GenEvent(0,number);
+    HepMC::GenVertex* primary = new HepMC::GenVertex(HepMC::FourVector(0.,0.,0.,0.));
+    event->add_vertex(primary);
+    event->set_signal_process_vertex(primary);
+    primary->add_particle_in(new HepMC::GenParticle(HepMC::FourVector(0.,0.,4000.,4000.),2212,3));
+    primary->add_particle_in(new HepMC::GenParticle(HepMC::FourVector(0.,0.,-4000.,4000.),2212,3));
+
+    for ( unsigned ip=0; ip<nParticles; ++ip ) {
+
+      double species = random.Uniform();
+      int sign = random.Uniform() < 0.5 ? -1 : 1;
+
+      if ( species < 0.70 ) {
+	primary->add_particle_out(new HepMC::GenParticle(momentum(random,0.13957,0.5),sign*211,1));
+      } else if ( species < 0.80 ) {
+	primary->add_particle_out(new HepMC::GenParticle(momentum(random,0.49368,0.5),sign*321,1));
+      } else if ( species < 0.85 ) {
+	primary->add_particle_out(new HepMC::GenParticle(momentum(random,0.93827,0.5),sign*2212,1));
+      } else if ( species < 0.95 ) {
+	// pi0 -> gamma gamma, at the primary vertex
+	HepMC::FourVector p = momentum(random,0.13498,0.5);
+	HepMC::GenParticle* pi0 = new HepMC::GenParticle(p,111,2);
+	primary->add_particle_out(pi0);
+	HepMC::GenVertex* end = new HepMC::GenVertex(HepMC::FourVector(0.,0.,0.,0.));
+	event->add_vertex(end);
+	end->add_particle_in(pi0);
+	HepMC::FourVector p1, p2;
+	decay(random,p,0.13498,0.,0.,p1,p2);
+	end->add_particle_out(new HepMC::GenParticle(p1,22,1));
+	end->add_particle_out(new HepMC::GenParticle(p2,22,1));
+      } else {
+	// K0S -> pi+ pi-, a few cm away
+	HepMC::FourVector p = momentum(random,0.49761,0.5);
+	HepMC::GenParticle* k0s = new HepMC::GenParticle(p,310,2);
+	primary->add_particle_out(k0s);
+	double flight = random.Exp(26.84) / 0.49761;
+	HepMC::GenVertex* end =
+	  new HepMC::GenVertex(HepMC::FourVector(p.px()*flight,p.py()*flight,
+						 p.pz()*flight,p.e()*flight));
+	event->add_vertex(end);
+	end->add_particle_in(k0s);
+	HepMC::FourVector p1, p2;
+	decay(random,p,0.49761,0.13957,0.13957,p1,p2);
+	end->add_particle_out(new HepMC::GenParticle(p1,211,1));
+	end->add_particle_out(new HepMC::GenParticle(p2,-211,1));
+      }
+
+    }
+
+    return event;
+
+  }
+
+  /// The same event, as a GenParticleCollection (positions in cm)
+  inline void genParticles(const HepMC::GenEvent& event,
+			   const HepPDT::ParticleDataTable& pdt,
+			   reco::GenParticleCollection& particles) {
+
+    particles.clear();
+    particles.reserve(event.particles_size());
+    std::map<int,unsigned> index;
+    HepMC::GenEvent::particle_const_iterator piter;
+    for ( piter = event.particles_begin(); piter != event.particles_end(); ++piter ) {
+      const HepMC::GenParticle* p = *piter;
+      const HepPDT::ParticleData* data = pdt.particle(HepPDT::ParticleID(p->pdg_id()));
+      const HepMC::GenVertex* v = p->production_vertex();
+      math::XYZPoint vertex = v ? 
+	math::XYZPoint(v->position().x()/10.,v->position().y()/10.,v->position().z()/10.) :
+	math::XYZPoint();
+      index[p->barcode()] = particles.size();
+      particles.push_back(reco::GenParticle(data ? (int)data->charge() : 0,
+					    math::XYZTLorentzVector(p->momentum().px(),
+								    p->momentum().py(),
+								    p->momentum().pz(),
+								    p->momentum().e()),
+					    vertex,p->pdg_id(),p->status(),true));
+    }
+
+    // The mothers and daughters, once the collection does not move any more
+    for ( piter = event.particles_begin(); piter != event.particles_end(); ++piter ) {
+      const HepMC::GenParticle* p = *piter;
+      reco::GenParticle& particle = particles[index[p->barcode()]];
+      const HepMC::GenVertex* v = p->production_vertex();
+      if ( v && v->particles_in_const_begin() != v->particles_in_const_end() )
+	particle.addMother(reco::GenParticleRef(&particles,
+						index[(*v->particles_in_const_begin())->barcode()]));
+      v = p->end_vertex();
+      if ( !v ) continue;
+      HepMC::GenVertex::particles_out_const_iterator d;
+      for ( d = v->particles_out_const_begin(); d != v->particles_out_const_end(); ++d )
+	particle.addDaughter(reco::GenParticleRef(&particles,index[(*d)->barcode()]));
+    }
+
+  }
+
+  /// The SimTrack's and SimVertex'ices of an FSimEvent, with the tracker
+  /// surface states of straight tracks (as if read from the Geant output)
+  inline void simTracks(const FSimEvent& simEvent,
+			edm::SimTrackContainer& tracks,
+			edm::SimVertexContainer& vertices) {
+
+    edm::SimTrackContainer muons;
+    tracks.clear();
+    vertices.clear();
+    simEvent.load(tracks,muons);
+    simEvent.load(vertices);
+
+    // The tracker boundary, in cm
+    const double radius = 120.;
+    const double length = 280.;
+    for ( unsigned it=0; it<tracks.size(); ++it ) {
+      SimTrack& track = tracks[it];
+      const math::XYZTLorentzVectorD& p = track.momentum();
+      const math::XYZTLorentzVectorD& x = vertices[track.vertIndex()].position();
+      double pt = std::sqrt(p.px()*p.px()+p.py()*p.py());
+      double r = std::sqrt(x.x()*x.x()+x.y()*x.y());
+      double path = 0.;
+      if ( pt > 0. ) path = std::max(radius-r,0.) / pt;
+      if ( p.pz() != 0. ) {
+	double pathZ = ( (p.pz() > 0. ? length : -length) - x.z() ) / p.pz();
+	if ( pathZ >= 0. && ( pt == 0. || pathZ < path ) ) path = pathZ;
+      }
+      track.setTkPosition(math::XYZVectorD(x.x()+path*p.px(),
+					   x.y()+path*p.py(),
+					   x.z()+path*p.pz()));
+      track.setTkMomentum(p);
+    }
+
+  }
+
+}
+
+#endif // SyntheticEvents_H
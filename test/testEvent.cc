@@ -12,11 +12,14 @@
 #include "FastSimulation/Event/interface/FSimEvent.h"
 #include "FastSimulation/Event/interface/FSimTrack.h"
 #include "FastSimulation/Event/interface/FSimVertex.h"
+#include "FastSimulation/Event/interface/FSimParticleProperties.h"
+#include "FastSimulation/Event/interface/KineParticleFilter.h"
 #include "FastSimulation/Particle/interface/ParticleTable.h"
 
 #include "DQMServices/Core/interface/DQMStore.h"
 #include "DQMServices/Core/interface/MonitorElement.h"
 #include "FWCore/ServiceRegistry/interface/Service.h"
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -27,6 +30,7 @@ public :
 
   virtual void analyze(const edm::Event&, const edm::EventSetup& );
   virtual void beginRun(edm::Run const&, edm::EventSetup const&  );
+  virtual void endJob();
 private:
   
   // See RecoParticleFlow/PFProducer/interface/PFProducer.h
@@ -75,9 +79,20 @@ void testEvent::beginRun(edm::Run const&, edm::EventSetup const& es)
   edm::ESHandle < HepPDT::ParticleDataTable > pdt;
   es.getData(pdt);
   if ( !ParticleTable::instance() ) ParticleTable::instance(&(*pdt));
-  if ( isGeant ) mySimEvent[0]->initializePdt(&(*pdt));
-  mySimEvent[1]->initializePdt(&(*pdt));
 
+  // The properties of the particles, made once and shared by the events
+  std::shared_ptr<const FSimParticleProperties> properties = 
+    std::make_shared<const FSimParticleProperties>(*pdt,KineParticleFilter(particleFilter_));
+  if ( isGeant ) mySimEvent[0]->initializePdt(&(*pdt),properties);
+  mySimEvent[1]->initializePdt(&(*pdt),properties);
+
+}
+
+void testEvent::endJob()
+{
+  // The particle filter summary (if requested)
+  if ( isGeant ) mySimEvent[0]->endJob();
+  mySimEvent[1]->endJob();
 }
 
 void
@@ -0,0 +1,418 @@
+/** Micro-benchmarks of the hot paths of FBaseSimEvent, on synthetic
+ *  events (see SyntheticEvents.h) of several topologies, from a single
+ *  particle to heavy ion multiplicities. For each benchmark and topology,
+ *  the time per event is the best of a few repetitions of a loop long
+ *  enough to be measured; the results are written in JSON, to be compared
+ *  between releases.
+ *
+ *  Usage: testEventBenchmarks [options]
+ *    -t time       minimum duration of a repetition, in s (default 0.2)
+ *    -r number     number of repetitions (default 5)
+ *    -e events     number of events per topology (default 4)
+ *    -b name       run only the benchmarks whose name contains this string
+ *    -T name       run only the topologies whose name contains this string
+ *    -o file       write the results to this file (default: standard output)
+ *    -P tracks     propagate to the calorimeters in parallel, by blocks of
+ *                  this many tracks (default: serial)
+ */
+
+// CMSSW Headers
+#include "DataFormats/Provenance/interface/EventID.h"
+#include "SimGeneral/HepPDTRecord/interface/ParticleDataTable.h"
+
+// FAMOS Headers
+#include "FastSimulation/Event/interface/FSimEvent.h"
+#include "FastSimulation/Event/interface/KineParticleFilter.h"
+#include "FastSimulation/Event/interface/BetaFuncPrimaryVertexGenerator.h"
+#include "FastSimulation/Particle/interface/ParticleTable.h"
+#include "FastSimulation/Particle/interface/RawParticle.h"
+#include "FastSimulation/Utilities/interface/RandomEngine.h"
+#include "FastSimulation/Event/test/SyntheticEvents.h"
+#include "FastSimulation/Event/test/BenchmarkTools.h"
+
+// ROOT
+#include "TRandom3.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+  /// The event topologies, by number of generated particles
+  struct Topology {
+    const char* name;
+    unsigned nParticles;
+  };
+
+  const Topology topologies[] = {
+    { "SingleParticle",     1 },
+    { "TTbar",           1000 },
+    { "MinBiasPU50",     5000 },
+    { "MinBiasPU140",   14000 },
+    { "MinBiasPU200",   20000 },
+    { "HeavyIon",       30000 }
+  };
+  const unsigned nTopologies = sizeof(topologies)/sizeof(Topology);
+
+  /// The benchmarks
+  enum Benchmark {
+    ADDSIMTRACK, ADDSIMVERTEX, ACCEPT, ACCEPTBATCH, ADDPARTICLES_HEPMC,
+    ADDPARTICLES_GENPARTICLES, FILL_SIMTRACKS, LOAD, VERTEX, VERTEXBATCH, BOOST, NBENCHMARKS
+  };
+
+  const char* name(Benchmark b) {
+    switch ( b ) {
+    case ADDSIMTRACK :               return "FBaseSimEvent::addSimTrack";
+    case ADDSIMVERTEX :              return "FBaseSimEvent::addSimVertex";
+    case ACCEPT :                    return "KineParticleFilter::accept";
+    case ACCEPTBATCH :               return "KineParticleFilter::acceptBatch";
+    case ADDPARTICLES_HEPMC :        return "FBaseSimEvent::addParticles(HepMC::GenEvent)";
+    case ADDPARTICLES_GENPARTICLES : return "FBaseSimEvent::addParticles(reco::GenParticleCollection)";
+    case FILL_SIMTRACKS :            return "FBaseSimEvent::fill(SimTrack,SimVertex)";
+    case LOAD :                      return "FSimEvent::load";
+    case VERTEX :                    return "PrimaryVertexGenerator::generate";
+    case VERTEXBATCH :               return "PrimaryVertexGenerator::generateBatch";
+    case BOOST :                     return "PrimaryVertexGenerator::applyBoost";
+    default : return "";
+    }
+  }
+
+  /// The events of a topology, in all the input formats
+  struct Events {
+    std::vector<HepMC::GenEvent*> genEvents;
+    std::vector<reco::GenParticleCollection> genParticles;
+    std::vector< std::vector<RawParticle> > particles;
+    // The same particles, as arrays
+    struct Arrays {
+      std::vector<double> px, py, pz, e, x, y, z, charge;
+      std::vector<int> pdgId, mask;
+    };
+    std::vector<Arrays> arrays;
+    std::vector<edm::SimTrackContainer> simTracks;
+    std::vector<edm::SimVertexContainer> simVertices;
+    // The output of FSimEvent::load
+    edm::SimTrackContainer tracks;
+    edm::SimTrackContainer muons;
+    edm::SimVertexContainer vertices;
+    // One primary vertex per pile-up interaction (~100 particles)
+    unsigned nInteractions;
+    PrimaryVertexGenerator::Batch interactions;
+    // The momenta of the particles, boosted for a crossing angle
+    const PrimaryVertexGenerator* crossing;
+    PrimaryVertexGenerator::Batch boosted;
+    ~Events() {
+      for ( unsigned iev=0; iev<genEvents.size(); ++iev ) delete genEvents[iev];
+    }
+  };
+
+  /// The result of the filter, kept so that the loop is not optimized away
+  volatile unsigned accepted = 0;
+
+  /// Run a benchmark on event iev, and return the number of items processed
+  unsigned run(Benchmark b, FSimEvent& simEvent, Events& events, unsigned iev) {
+
+    unsigned nItems = 0;
+    switch ( b ) {
+
+    case ADDSIMTRACK : {
+      const std::vector<RawParticle>& particles = events.particles[iev];
+      simEvent.clear();
+      int mainVertex = simEvent.addSimVertex(XYZTLorentzVector(),-1,FSimVertexType::PRIMARY_VERTEX);
+      for ( unsigned ip=0; ip<particles.size(); ++ip )
+	simEvent.addSimTrack(&particles[ip],mainVertex);
+      nItems = particles.size();
+      break;
+    }
+
+    case ADDSIMVERTEX : {
+      const std::vector<RawParticle>& particles = events.particles[iev];
+      simEvent.clear();
+      for ( unsigned ip=0; ip<particles.size(); ++ip )
+	simEvent.addSimVertex(particles[ip].vertex());
+      nItems = particles.size();
+      break;
+    }
+
+    case ACCEPT : {
+      const std::vector<RawParticle>& particles = events.particles[iev];
+      const KineParticleFilter& filter = simEvent.filter();
+      unsigned nAccepted = 0;
+      for ( unsigned ip=0; ip<particles.size(); ++ip )
+	nAccepted += filter.accept(particles[ip]);
+      accepted = nAccepted;
+      nItems = particles.size();
+      break;
+    }
+
+    case ACCEPTBATCH : {
+      Events::Arrays& a = events.arrays[iev];
+      accepted = simEvent.filter().acceptBatch(a.px.size(),&a.px[0],&a.py[0],&a.pz[0],&a.e[0],
+					       &a.x[0],&a.y[0],&a.z[0],&a.pdgId[0],&a.charge[0],
+					       &a.mask[0]);
+      nItems = a.px.size();
+      break;
+    }
+
+    case ADDPARTICLES_HEPMC :
+      simEvent.clear();
+      simEvent.addParticles(*events.genEvents[iev]);
+      nItems = events.genEvents[iev]->particles_size();
+      break;
+
+    case ADDPARTICLES_GENPARTICLES :
+      simEvent.clear();
+      simEvent.addParticles(events.genParticles[iev]);
+      nItems = events.genParticles[iev].size();
+      break;
+
+    case FILL_SIMTRACKS :
+      simEvent.fill(events.simTracks[iev],events.simVertices[iev]);
+      nItems = events.simTracks[iev].size();
+      break;
+
+    case LOAD :
+      // The event filled last (see measure)
+      events.tracks.clear();
+      events.muons.clear();
+      events.vertices.clear();
+      simEvent.load(events.tracks,events.muons);
+      simEvent.load(events.vertices);
+      nItems = events.tracks.size();
+      break;
+
+    case VERTEX : {
+      PrimaryVertexGenerator& vertexGenerator = *simEvent.thePrimaryVertexGenerator();
+      PrimaryVertexGenerator::Batch& v = events.interactions;
+      v.resize(events.nInteractions);
+      for ( unsigned i=0; i<events.nInteractions; ++i ) {
+	vertexGenerator.generate();
+	v.x[i] = vertexGenerator.X();
+	v.y[i] = vertexGenerator.Y();
+	v.z[i] = vertexGenerator.Z();
+      }
+      nItems = events.nInteractions;
+      break;
+    }
+
+    case VERTEXBATCH :
+      simEvent.thePrimaryVertexGenerator()->generateBatch(events.nInteractions,events.interactions);
+      nItems = events.nInteractions;
+      break;
+
+    case BOOST : {
+      const Events::Arrays& a = events.arrays[iev];
+      PrimaryVertexGenerator::Batch& p = events.boosted;
+      p.x = a.px;
+      p.y = a.py;
+      p.z = a.pz;
+      p.t = a.e;
+      events.crossing->applyBoost(p.size(),&p.x[0],&p.y[0],&p.z[0],&p.t[0]);
+      nItems = p.size();
+      break;
+    }
+
+    default : break;
+
+    }
+
+    return nItems;
+
+  }
+
+  /// The result of a benchmark
+  struct Result {
+    unsigned long iterations;
+    double nsPerEvent;
+    double itemsPerEvent;
+    double allocationsPerEvent;
+  };
+
+  /// Time a benchmark: the best of nRepetitions loops of at least minTime
+  Result measure(Benchmark b, FSimEvent& simEvent, Events& events,
+		 double minTime, unsigned nRepetitions) {
+
+    const unsigned nEvents = events.genEvents.size();
+    // FSimEvent::load reads the first event
+    if ( b == LOAD ) simEvent.fill(events.simTracks[0],events.simVertices[0]);
+    const unsigned n = b == LOAD ? 1 : nEvents;
+
+    // Warm up (the buffers grow to the largest event), and count the items
+    unsigned long nItems = 0;
+    for ( unsigned iev=0; iev<n; ++iev ) nItems += run(b,simEvent,events,iev);
+
+    // The number of iterations for a loop of at least minTime
+    unsigned long iterations = n;
+    double time = 0.;
+    for ( ;; ) {
+      double start = BenchmarkTools::now();
+      for ( unsigned long i=0; i<iterations; ++i ) run(b,simEvent,events,i%n);
+      time = BenchmarkTools::now() - start;
+      if ( time >= minTime || iterations >= 1UL<<30 ) break;
+      iterations *= time > 0. ? std::min(std::max((unsigned long)(1.2*minTime/time),2UL),100UL) : 100UL;
+    }
+
+    // The best repetition
+    double best = time;
+    unsigned long allocations = BenchmarkTools::nHeapAllocations();
+    for ( unsigned rep=1; rep<nRepetitions; ++rep ) {
+      double start = BenchmarkTools::now();
+      for ( unsigned long i=0; i<iterations; ++i ) run(b,simEvent,events,i%n);
+      time = BenchmarkTools::now() - start;
+      if ( time < best ) best = time;
+    }
+    allocations = BenchmarkTools::nHeapAllocations() - allocations;
+
+    Result result;
+    result.iterations = iterations;
+    result.nsPerEvent = 1E9*best/iterations;
+    result.itemsPerEvent = nItems/(double)n;
+    result.allocationsPerEvent =
+      nRepetitions > 1 ? allocations/((double)iterations*(nRepetitions-1)) : 0.;
+    return result;
+
+  }
+
+  void usage(const char* name) {
+    std::cerr << "Usage: " << name
+	      << " [-t time] [-r repetitions] [-e events] [-b benchmark] [-T topology]"
+	      << " [-o file] [-P tracks]" << std::endl;
+    std::exit(1);
+  }
+
+}
+
+int main(int argc, char** argv) {
+
+  double minTime = 0.2;
+  unsigned nRepetitions = 5;
+  unsigned nEvents = 4;
+  std::string benchmarkFilter;
+  std::string topologyFilter;
+  std::string output;
+  unsigned tracksPerBlock = 0;
+
+  for ( int i=1; i<argc; ++i ) {
+    std::string arg(argv[i]);
+    if ( arg.size() != 2 || arg[0] != '-' || i+1 == argc ) usage(argv[0]);
+    const char* value = argv[++i];
+    switch ( arg[1] ) {
+    case 't' : minTime = std::atof(value); break;
+    case 'r' : nRepetitions = std::atoi(value); break;
+    case 'e' : nEvents = std::atoi(value); break;
+    case 'b' : benchmarkFilter = value; break;
+    case 'T' : topologyFilter = value; break;
+    case 'o' : output = value; break;
+    case 'P' : tracksPerBlock = std::atoi(value); break;
+    default : usage(argv[0]);
+    }
+  }
+  if ( !nEvents || !nRepetitions ) usage(argv[0]);
+
+  // The particle data table
+  HepPDT::ParticleDataTable pdt("testEventBenchmarks");
+  BenchmarkTools::minimalTable(pdt);
+  ParticleTable::instance(&pdt);
+
+  // The fast simulation event
+  TRandom3 smearing(4357);
+  RandomEngine random(&smearing);
+  FSimEvent simEvent(BenchmarkTools::vertexGenerator("Gaussian"),
+		     BenchmarkTools::particleFilter(),&random);
+  simEvent.initializePdt(&pdt);
+  if ( tracksPerBlock ) simEvent.setParallelPropagation(true,tracksPerBlock);
+
+  // A vertex generator with a crossing angle
+  edm::ParameterSet crossingAngle = BenchmarkTools::vertexGenerator("BetaFunc");
+  crossingAngle.addParameter<double>("Phi",0.000142);
+  BetaFuncPrimaryVertexGenerator crossing(crossingAngle,&random);
+
+  std::ofstream file;
+  if ( !output.empty() ) file.open(output.c_str());
+  std::ostream& json = output.empty() ? std::cout : file;
+  json << "{" << std::endl
+       << "  \"package\": \"FastSimulation/Event\"," << std::endl
+       << "  \"eventsPerTopology\": " << nEvents << "," << std::endl
+       << "  \"minTime\": " << minTime << "," << std::endl
+       << "  \"repetitions\": " << nRepetitions << "," << std::endl
+       << "  \"tracksPerBlock\": " << tracksPerBlock << "," << std::endl
+       << "  \"benchmarks\": [";
+
+  TRandom3 generator(12345);
+  bool first = true;
+  for ( unsigned it=0; it<nTopologies; ++it ) {
+
+    const Topology& topology = topologies[it];
+    if ( std::string(topology.name).find(topologyFilter) == std::string::npos ) continue;
+
+    // The events, in all the input formats
+    Events events;
+    events.nInteractions = topology.nParticles/100 + 1;
+    events.crossing = &crossing;
+    edm::EventID id(1,1,0);
+    for ( unsigned iev=0; iev<nEvents; ++iev ) {
+      HepMC::GenEvent* genEvent = SyntheticEvents::genEvent(generator,topology.nParticles,iev);
+      events.genEvents.push_back(genEvent);
+      events.genParticles.push_back(reco::GenParticleCollection());
+      SyntheticEvents::genParticles(*genEvent,pdt,events.genParticles.back());
+      const reco::GenParticleCollection& genParticles = events.genParticles.back();
+      events.particles.push_back(std::vector<RawParticle>());
+      std::vector<RawParticle>& particles = events.particles.back();
+      for ( unsigned ip=0; ip<genParticles.size(); ++ip ) {
+	const reco::GenParticle& p = genParticles[ip];
+	particles.push_back(RawParticle(XYZTLorentzVector(p.px(),p.py(),p.pz(),p.energy()),
+					XYZTLorentzVector(p.vx(),p.vy(),p.vz(),0.)));
+	particles.back().setID(p.pdgId());
+      }
+      events.arrays.push_back(Events::Arrays());
+      Events::Arrays& a = events.arrays.back();
+      for ( unsigned ip=0; ip<particles.size(); ++ip ) {
+	const RawParticle& p = particles[ip];
+	a.px.push_back(p.Px());
+	a.py.push_back(p.Py());
+	a.pz.push_back(p.Pz());
+	a.e.push_back(p.E());
+	a.x.push_back(p.X());
+	a.y.push_back(p.Y());
+	a.z.push_back(p.Z());
+	a.pdgId.push_back(p.pid());
+	a.charge.push_back(p.charge());
+      }
+      a.mask.resize(particles.size());
+      simEvent.fill(*genEvent,id);
+      events.simTracks.push_back(edm::SimTrackContainer());
+      events.simVertices.push_back(edm::SimVertexContainer());
+      SyntheticEvents::simTracks(simEvent,events.simTracks.back(),events.simVertices.back());
+    }
+
+    for ( unsigned ib=0; ib<NBENCHMARKS; ++ib ) {
+
+      Benchmark b = (Benchmark)ib;
+      if ( std::string(name(b)).find(benchmarkFilter) == std::string::npos ) continue;
+      Result result = measure(b,simEvent,events,minTime,nRepetitions);
+
+      json << ( first ? "" : "," ) << std::endl
+	   << "    { \"name\": \"" << name(b) << "\","
+	   << " \"topology\": \"" << topology.name << "\","
+	   << " \"particles\": " << topology.nParticles << ","
+	   << " \"items\": " << result.itemsPerEvent << ","
+	   << " \"iterations\": " << result.iterations << ","
+	   << " \"nsPerEvent\": " << result.nsPerEvent << ","
+	   << " \"nsPerItem\": "
+	   << ( result.itemsPerEvent > 0. ? result.nsPerEvent/result.itemsPerEvent : 0. ) << ","
+	   << " \"allocationsPerEvent\": " << result.allocationsPerEvent << " }";
+      first = false;
+
+    }
+
+  }
+
+  json << std::endl << "  ]," << std::endl
+       << "  \"peakRSSMB\": " << BenchmarkTools::peakRSS() << std::endl
+       << "}" << std::endl;
+  return 0;
+
+}
@@ -0,0 +1,615 @@
+/** A standalone driver checking the consistency of FBaseSimEvent, outside
+ *  of cmsRun, on the events of SyntheticEvents.h. Each check prints the
+ *  cases that fail; the program returns a non-zero status if any does,
+ *  and can thus be run as a unit test.
+ *
+ *  Checks:
+ *    steadyState  once the buffers have grown to the largest event,
+ *                 filling the same events again does not grow them
+ *    batchPropagation  the batch propagator (FSimBatchPropagator) finds
+ *                 the same calorimeter states as BaseParticlePropagator:
+ *                 the same success on every surface and, when the surface
+ *                 is reached, the same position (within 10 microns) and
+ *                 momentum (within 1E-5 relative)
+ *    lazyPropagation  the lazy propagation, triggered by the calorimeter
+ *                 accessors of the FSimTrack's in any surface order, finds
+ *                 the same states as the eager propagation
+ *    classify     FSimGenRecord::classify and classifyReference give the
+ *                 same keep and stable masks, on the synthetic events and
+ *                 on hand-made edge cases (late decays, displaced vertices,
+ *                 particles declared stable, prompt brems, an empty event)
+ *    acceptBatch  KineParticleFilter::acceptBatch accepts the same particles
+ *                 as accept(), on the synthetic events and on hand-made edge
+ *                 cases (proton taggers with forbidden codes, thresholds,
+ *                 zero momentum, origin vertex at (0,0,0)...), with and
+ *                 without forbidden codes and main vertex offset
+ *    particleProperties  the particle properties shared by the events
+ *                 agree with the table and with the particle filter, and
+ *                 are refused with another table
+ *
+ *  Usage: testEventConsistency [-e events] [-s particles]
+ */
+
+// CMSSW Headers
+#include "DataFormats/Provenance/interface/EventID.h"
+#include "FWCore/Utilities/interface/Exception.h"
+#include "SimGeneral/HepPDTRecord/interface/ParticleDataTable.h"
+
+// FAMOS Headers
+#include "FastSimulation/Event/interface/FSimEvent.h"
+#include "FastSimulation/Event/interface/FSimGenRecord.h"
+#include "FastSimulation/Event/interface/FSimParticleProperties.h"
+#include "FastSimulation/Event/interface/KineParticleFilter.h"
+#include "FastSimulation/Particle/interface/ParticleTable.h"
+#include "FastSimulation/Particle/interface/RawParticle.h"
+#include "FastSimulation/Utilities/interface/RandomEngine.h"
+#include "FastSimulation/Event/test/SyntheticEvents.h"
+#include "FastSimulation/Event/test/BenchmarkTools.h"
+
+// ROOT
+#include "TRandom3.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+  void usage(const char* name) {
+    std::cerr << "Usage: " << name << " [-e events] [-s particles]" << std::endl;
+    std::exit(1);
+  }
+
+  /// The synthetic events, in all the input formats
+  struct Events {
+    ~Events() { for ( unsigned iev=0; iev<genEvents.size(); ++iev ) delete genEvents[iev]; }
+    std::vector<HepMC::GenEvent*> genEvents;
+    std::vector<reco::GenParticleCollection> genParticles;
+    std::vector<edm::SimTrackContainer> simTracks;
+    std::vector<edm::SimVertexContainer> simVertices;
+  };
+
+  /// A particle produced at vertex from (if any), decaying at vertex to 
+  /// (if any)
+  HepMC::GenParticle* particle(int pdgId, int status, const HepMC::FourVector& p,
+			       HepMC::GenVertex* from, HepMC::GenVertex* to=0) {
+    HepMC::GenParticle* part = new HepMC::GenParticle(p,pdgId,status);
+    if ( from ) from->add_particle_out(part);
+    if ( to ) to->add_particle_in(part);
+    return part;
+  }
+
+  /// A vertex at (x,y,z), in mm
+  HepMC::GenVertex* vertex(HepMC::GenEvent* event, double x, double y, double z) {
+    HepMC::GenVertex* v = new HepMC::GenVertex(HepMC::FourVector(x,y,z,0.));
+    event->add_vertex(v);
+    return v;
+  }
+
+  /// The edge cases of the classification of the generated particles 
+  /// (the caller owns the events)
+  void edgeCases(std::vector<HepMC::GenEvent*>& events) {
+
+    const HepMC::FourVector p(1.,2.,3.,4.);
+
+    // An empty event
+    events.push_back(new HepMC::GenEvent(0,1000));
+
+    // Late decays (the beam pipe is at 25 mm), and an exotic particle 
+    // decaying late, never declared stable
+    HepMC::GenEvent* late = new HepMC::GenEvent(0,1001);
+    HepMC::GenVertex* primary = vertex(late,0.,0.,0.);
+    late->set_signal_process_vertex(primary);
+    particle(2212,3,HepMC::FourVector(0.,0.,4000.,4000.),0,primary);
+    HepMC::GenVertex* justInside = vertex(late,24.9,0.,10.);
+    particle(310,2,p,primary,justInside);
+    particle(211,1,p,justInside);
+    particle(-211,1,p,justInside);
+    HepMC::GenVertex* justOutside = vertex(late,0.,25.1,-10.);
+    particle(310,2,p,primary,justOutside);
+    particle(211,1,p,justOutside);
+    particle(-211,1,p,justOutside);
+    HepMC::GenVertex* exotic = vertex(late,300.,0.,0.);
+    particle(1000022,2,p,primary,exotic);
+    particle(22,1,p,exotic);
+    // A late decay to unstable daughters only
+    HepMC::GenVertex* cascade = vertex(late,100.,100.,0.);
+    particle(3122,2,p,primary,cascade);
+    HepMC::GenVertex* cascadeEnd = vertex(late,110.,100.,0.);
+    particle(111,2,p,cascade,cascadeEnd);
+    particle(22,1,p,cascadeEnd);
+    particle(22,1,p,cascadeEnd);
+    events.push_back(late);
+
+    // Displaced vertices: particles produced more or less than one 
+    // micron away from the primary vertex, whatever their status
+    HepMC::GenEvent* displaced = new HepMC::GenEvent(0,1002);
+    primary = vertex(displaced,0.,0.,0.);
+    displaced->set_signal_process_vertex(primary);
+    particle(2212,3,HepMC::FourVector(0.,0.,4000.,4000.),0,primary);
+    HepMC::GenVertex* close = vertex(displaced,0.0005,0.0005,0.);
+    particle(23,3,p,primary,close);
+    particle(13,3,p,close);
+    particle(-13,3,p,close);
+    HepMC::GenVertex* far = vertex(displaced,0.,0.,0.02);
+    particle(23,3,p,primary,far);
+    particle(11,3,p,far);
+    particle(-11,3,p,far);
+    events.push_back(displaced);
+
+    // Particles declared stable (status 1001), or undecayed with status 2
+    HepMC::GenEvent* stable = new HepMC::GenEvent(0,1003);
+    primary = vertex(stable,0.,0.,0.);
+    stable->set_signal_process_vertex(primary);
+    particle(2212,3,HepMC::FourVector(0.,0.,4000.,4000.),0,primary);
+    particle(211,1001,p,primary);
+    particle(321,2,p,primary);
+    HepMC::GenVertex* decay = vertex(stable,1.,1.,1.);
+    particle(-15,2,p,primary,decay);
+    particle(-211,1001,p,decay);
+    particle(-16,1,p,decay);
+    events.push_back(stable);
+
+    // Prompt electron and muon brems (not kept for their daughters), 
+    // and a late one
+    HepMC::GenEvent* brem = new HepMC::GenEvent(0,1004);
+    primary = vertex(brem,0.,0.,0.);
+    brem->set_signal_process_vertex(primary);
+    particle(2212,3,HepMC::FourVector(0.,0.,4000.,4000.),0,primary);
+    HepMC::GenVertex* electronBrem = vertex(brem,0.,0.,0.);
+    particle(11,2,p,primary,electronBrem);
+    particle(11,1,p,electronBrem);
+    particle(22,1,p,electronBrem);
+    HepMC::GenVertex* muonBrem = vertex(brem,1.,0.,0.);
+    particle(-13,2,p,primary,muonBrem);
+    particle(-13,1,p,muonBrem);
+    particle(22,1,p,muonBrem);
+    HepMC::GenVertex* lateBrem = vertex(brem,0.,30.,0.);
+    particle(13,2,p,primary,lateBrem);
+    particle(13,2,p,lateBrem);
+    particle(22,1,p,lateBrem);
+    events.push_back(brem);
+
+  }
+
+  /// Classify the particles of an event with classify and with
+  /// classifyReference, and compare the masks
+  unsigned classify(FSimGenRecord& record, const HepMC::GenEvent& event,
+		    const math::XYZTLorentzVector& primaryVertex,
+		    const math::XYZTLorentzVector& smearing,
+		    double lateVertexPosition) {
+
+    record.fill(event);
+    const unsigned n = record.size();
+    record.classify(primaryVertex,smearing,lateVertexPosition);
+    std::vector<int> keep(record.keepMask(),record.keepMask()+n);
+    std::vector<int> stable(record.stableMask(),record.stableMask()+n);
+    record.classifyReference(primaryVertex,smearing,lateVertexPosition);
+
+    unsigned nFailures = 0;
+    for ( unsigned i=0; i<n; ++i ) {
+      if ( !keep[i] == !record.kept(i) && !stable[i] == !record.declaredStable(i) ) continue;
+      std::cerr << "classify: event " << event.event_number() << ", particle " << i
+		<< " (" << record.pdgId(i) << ", status " << record.status(i) << "):"
+		<< " kept " << keep[i] << " instead of " << record.kept(i) << ","
+		<< " stable " << stable[i] << " instead of " << record.declaredStable(i) 
+		<< std::endl;
+      ++nFailures;
+    }
+    return nFailures;
+
+  }
+
+  /// Compare classify and classifyReference on the synthetic events and
+  /// on the edge cases, with and without vertex smearing
+  unsigned classify(const Events& events) {
+
+    std::vector<HepMC::GenEvent*> genEvents(events.genEvents);
+    std::vector<HepMC::GenEvent*> edges;
+    edgeCases(edges);
+    genEvents.insert(genEvents.end(),edges.begin(),edges.end());
+
+    // The primary vertex and the smearing (in cm), and the beam pipe
+    std::vector< std::pair<math::XYZTLorentzVector,math::XYZTLorentzVector> > vertices;
+    vertices.push_back(std::make_pair(math::XYZTLorentzVector(),math::XYZTLorentzVector()));
+    vertices.push_back(std::make_pair(math::XYZTLorentzVector(0.0322,0.,0.,0.),
+				      math::XYZTLorentzVector(0.0322,0.,1.3,0.)));
+    vertices.push_back(std::make_pair(math::XYZTLorentzVector(),
+				      math::XYZTLorentzVector(0.,-0.05,-4.,0.)));
+    const double lateVertexPosition = 2.5*2.5;
+
+    FSimGenRecord record;
+    unsigned nFailures = 0;
+    for ( unsigned iev=0; iev<genEvents.size(); ++iev ) 
+      for ( unsigned iv=0; iv<vertices.size(); ++iv ) 
+	nFailures += classify(record,*genEvents[iev],
+			      vertices[iv].first,vertices[iv].second,lateVertexPosition);
+
+    for ( unsigned iev=0; iev<edges.size(); ++iev ) delete edges[iev];
+    return nFailures;
+
+  }
+
+  /// A particle of this PDG id, momentum and origin vertex (in cm)
+  RawParticle rawParticle(int pdgId, double px, double py, double pz, double e,
+			  double x=0., double y=0., double z=0.) {
+    RawParticle p(math::XYZTLorentzVector(px,py,pz,e),math::XYZTLorentzVector(x,y,z,0.));
+    p.setID(pdgId);
+    return p;
+  }
+
+  /// The edge cases of the particle filter (default cuts: EProton = 5000, 
+  /// EMin = 0.1, pTMin = 0.2, etaMax = 5.1, with 2212, 211 and 1000022 
+  /// forbidden in one of the filters)
+  void filterEdgeCases(std::vector<RawParticle>& particles) {
+    // Proton taggers, accepted before the forbidden codes are checked,
+    // and just below the threshold
+    particles.push_back(rawParticle(2212,0.,0.,6000.,6000.));
+    particles.push_back(rawParticle(-2212,0.,0.,-5000.,5000.));
+    particles.push_back(rawParticle(2212,0.,0.,4999.,4999.1));
+    particles.push_back(rawParticle(2212,0.,0.,6000.,6000.,500.,0.,0.));
+    // Forbidden codes, below and above the species table
+    particles.push_back(rawParticle(211,1.,0.,0.,1.01));
+    particles.push_back(rawParticle(-211,1.,0.,0.,1.01));
+    particles.push_back(rawParticle(1000022,10.,0.,0.,100.5));
+    // Species never simulated (quark, gluon, neutrino, Z)
+    particles.push_back(rawParticle(2,1.,0.,0.,1.));
+    particles.push_back(rawParticle(21,1.,0.,0.,1.));
+    particles.push_back(rawParticle(12,1.,0.,0.,1.));
+    particles.push_back(rawParticle(23,1.,0.,0.,91.2));
+    // At the energy and pT thresholds, for charged and neutral particles
+    particles.push_back(rawParticle(22,0.1,0.,0.,0.1));
+    particles.push_back(rawParticle(22,0.0999,0.,0.,0.0999));
+    particles.push_back(rawParticle(321,0.2,0.,0.,0.53));
+    particles.push_back(rawParticle(321,0.1999,0.,0.,0.53));
+    particles.push_back(rawParticle(2112,0.01,0.,0.,0.94));
+    // Zero momentum (cos^2(theta) is 0/0) and pT = 0
+    particles.push_back(rawParticle(2112,0.,0.,0.,0.94));
+    particles.push_back(rawParticle(22,0.,0.,0.,0.));
+    particles.push_back(rawParticle(22,0.,0.,10.,10.));
+    particles.push_back(rawParticle(22,0.,0.,0.,0.94,6.,0.,0.));
+    // Origin vertex at (0,0,0) (cos^2(theta) of the vertex is 0/0), 
+    // on the beam axis, in the preshower region, beyond the ECAL
+    particles.push_back(rawParticle(211,1.,1.,1.,1.74,0.,0.,0.));
+    particles.push_back(rawParticle(211,1.,1.,1.,1.74,0.,0.,300.));
+    particles.push_back(rawParticle(211,1.,1.,1.,1.74,0.,0.,320.));
+    particles.push_back(rawParticle(22,1.,1.,20.,20.1,150.,0.,300.));
+    particles.push_back(rawParticle(22,1.,1.,20.,20.1,129.,0.,0.));
+    particles.push_back(rawParticle(22,1.,1.,20.,20.1,130.,0.,0.));
+    // Beyond etaMax, close to the beam or more than 5 cm away
+    particles.push_back(rawParticle(22,0.01,0.,100.,100.));
+    particles.push_back(rawParticle(22,0.01,0.,100.,100.,4.,3.,0.));
+    particles.push_back(rawParticle(22,0.01,0.,100.,100.,5.,3.,0.));
+  }
+
+  /// Compare acceptBatch with accept, particle by particle
+  unsigned acceptBatch(const KineParticleFilter& filter, 
+		       const std::vector<RawParticle>& particles, 
+		       const char* sample) {
+
+    const unsigned n = particles.size();
+    std::vector<double> px(n), py(n), pz(n), e(n), x(n), y(n), z(n), charge(n);
+    std::vector<int> pdgId(n), mask(n);
+    for ( unsigned i=0; i<n; ++i ) {
+      const RawParticle& p = particles[i];
+      px[i] = p.Px(); py[i] = p.Py(); pz[i] = p.Pz(); e[i] = p.E();
+      x[i] = p.X(); y[i] = p.Y(); z[i] = p.Z();
+      pdgId[i] = p.pid();
+      charge[i] = p.charge();
+    }
+    if ( !n ) return 0;
+    unsigned nAccepted = 
+      filter.acceptBatch(n,&px[0],&py[0],&pz[0],&e[0],&x[0],&y[0],&z[0],
+			 &pdgId[0],&charge[0],&mask[0]);
+
+    unsigned nFailures = 0;
+    unsigned nExpected = 0;
+    for ( unsigned i=0; i<n; ++i ) {
+      bool expected = filter.accept(particles[i]);
+      nExpected += expected;
+      if ( mask[i] == (int)expected ) continue;
+      std::cerr << "acceptBatch: " << sample << ", particle " << i 
+		<< " (" << pdgId[i] << ", E = " << e[i] << ", origin "
+		<< x[i] << " " << y[i] << " " << z[i] << "): "
+		<< mask[i] << " instead of " << expected << std::endl;
+      ++nFailures;
+    }
+    if ( nAccepted != nExpected ) { 
+      std::cerr << "acceptBatch: " << sample << ", " << nAccepted 
+		<< " particles accepted instead of " << nExpected << std::endl;
+      ++nFailures;
+    }
+    return nFailures;
+
+  }
+
+  /// Compare acceptBatch with accept on the synthetic events and on the
+  /// edge cases, with the default cuts and with forbidden codes, for
+  /// two main vertices
+  unsigned acceptBatch(const Events& events) {
+
+    edm::ParameterSet kine = BenchmarkTools::particleFilter();
+    KineParticleFilter filter(kine);
+    std::vector<int> forbidden;
+    forbidden.push_back(2212);
+    forbidden.push_back(211);
+    forbidden.push_back(1000022);
+    kine.addUntrackedParameter< std::vector<int> >("forbiddenPdgCodes",forbidden);
+    KineParticleFilter forbidding(kine);
+    KineParticleFilter* filters[2] = { &filter, &forbidding };
+
+    // The particles of the synthetic events, and the edge cases
+    std::vector< std::vector<RawParticle> > samples(events.genParticles.size()+1);
+    for ( unsigned iev=0; iev<events.genParticles.size(); ++iev ) {
+      const reco::GenParticleCollection& genParticles = events.genParticles[iev];
+      for ( unsigned ip=0; ip<genParticles.size(); ++ip ) {
+	const reco::GenParticle& p = genParticles[ip];
+	samples[iev].push_back(rawParticle(p.pdgId(),p.px(),p.py(),p.pz(),p.energy(),
+					   p.vx(),p.vy(),p.vz()));
+      }
+    }
+    filterEdgeCases(samples.back());
+
+    unsigned nFailures = 0;
+    for ( unsigned iv=0; iv<2; ++iv ) {
+      XYZTLorentzVector mainVertex = iv ? XYZTLorentzVector(3.,4.,1.,0.) : XYZTLorentzVector();
+      for ( unsigned ifilter=0; ifilter<2; ++ifilter ) { 
+	filters[ifilter]->setMainVertex(mainVertex);
+	for ( unsigned is=0; is<samples.size(); ++is ) 
+	  nFailures += acceptBatch(*filters[ifilter],samples[is],
+				   is+1 < samples.size() ? "event" : "edge cases");
+      }
+    }
+    return nFailures;
+
+  }
+
+  /// Fill all the events once from each input format
+  void fillAll(FSimEvent& simEvent, const Events& events) {
+    edm::EventID id(1,1,0);
+    for ( unsigned iev=0; iev<events.genEvents.size(); ++iev ) {
+      simEvent.fill(*events.genEvents[iev],id);
+      simEvent.fill(events.genParticles[iev],id);
+      simEvent.fill(events.simTracks[iev],events.simVertices[iev]);
+    }
+  }
+
+  /// A first pass grows the buffers: a second pass over the same events
+  /// must not grow them any more
+  unsigned steadyState(FSimEvent& simEvent, const Events& events) {
+    fillAll(simEvent,events);
+    unsigned long warm = simEvent.nAllocations();
+    fillAll(simEvent,events);
+    unsigned long growths = simEvent.nAllocations() - warm;
+    if ( !growths ) return 0;
+    std::cerr << "steadyState: the buffers grew " << growths
+	      << " times after the warm-up" << std::endl;
+    return 1;
+  }
+
+  /// The success of the propagation of a track to a surface
+  int success(const FSimTrack& track, FSimSurfaceTable::Surface s) {
+    switch ( s ) {
+    case FSimSurfaceTable::LAYER1 : return track.onLayer1();
+    case FSimSurfaceTable::LAYER2 : return track.onLayer2();
+    case FSimSurfaceTable::ECAL : return track.onEcal();
+    case FSimSurfaceTable::HCAL : return track.onHcal();
+    case FSimSurfaceTable::VFCAL : return track.onVFcal();
+    case FSimSurfaceTable::HCALEXIT : return track.outHcal();
+    case FSimSurfaceTable::HO : return track.onHO();
+    default : return 0;
+    }
+  }
+
+  /// The state of a track on a surface
+  const RawParticle& state(const FSimTrack& track, FSimSurfaceTable::Surface s) {
+    switch ( s ) {
+    case FSimSurfaceTable::LAYER1 : return track.layer1Entrance();
+    case FSimSurfaceTable::LAYER2 : return track.layer2Entrance();
+    case FSimSurfaceTable::ECAL : return track.ecalEntrance();
+    case FSimSurfaceTable::HCAL : return track.hcalEntrance();
+    case FSimSurfaceTable::VFCAL : return track.vfcalEntrance();
+    case FSimSurfaceTable::HCALEXIT : return track.hcalExit();
+    default : return track.hoEntrance();
+    }
+  }
+
+  /// Compare the calorimeter states of the tracks of two events filled
+  /// from the same SimTrack's: the same success on every surface and,
+  /// when the surface is reached, the same position and momentum
+  unsigned compareStates(const char* check, unsigned iev, 
+			 const FSimEvent& expectedEvent, const FSimEvent& foundEvent) {
+
+    const double positionTolerance = 1E-3;  // cm
+    const double momentumTolerance = 1E-5;  // relative
+
+    if ( expectedEvent.nTracks() != foundEvent.nTracks() ) {
+      std::cerr << check << ": event " << iev << ", "
+		<< foundEvent.nTracks() << " tracks instead of " << expectedEvent.nTracks() << std::endl;
+      return 1;
+    }
+
+    unsigned nFailures = 0;
+    for ( unsigned it=0; it<expectedEvent.nTracks(); ++it ) {
+      for ( unsigned is=0; is<FSimSurfaceTable::NSURFACES; ++is ) {
+	FSimSurfaceTable::Surface s = (FSimSurfaceTable::Surface)is;
+	int expected = success(expectedEvent.track(it),s);
+	int found = success(foundEvent.track(it),s);
+	double dx = 0., dp = 0.;
+	// The states are compared where the surface is reached
+	if ( found == expected && expected > 0 ) { 
+	  const RawParticle& a = state(expectedEvent.track(it),s);
+	  const RawParticle& b = state(foundEvent.track(it),s);
+	  dx = std::sqrt((a.vertex().Vect()-b.vertex().Vect()).Mag2());
+	  dp = std::sqrt((a.momentum().Vect()-b.momentum().Vect()).Mag2()) /
+	    std::sqrt(a.momentum().Vect().Mag2());
+	}
+	if ( found == expected && dx < positionTolerance && dp < momentumTolerance ) continue;
+	std::cerr << check << ": event " << iev << ", track " << it 
+		  << " (" << expectedEvent.track(it).type() << "), surface " << is 
+		  << ": success " << found << " instead of " << expected 
+		  << ", position off by " << dx << " cm, momentum by " << dp << std::endl;
+	++nFailures;
+      }
+    }
+    return nFailures;
+
+  }
+
+  /// Fill the same SimTrack's with BaseParticlePropagator (scalar) and
+  /// with FSimBatchPropagator (batch), and compare the states found
+  unsigned batchPropagation(FSimEvent& scalar, FSimEvent& batch, const Events& events) {
+
+    unsigned nFailures = 0;
+    scalar.setBatchPropagation(false);
+    batch.setBatchPropagation(true);
+    for ( unsigned iev=0; iev<events.simTracks.size(); ++iev ) {
+      scalar.fill(events.simTracks[iev],events.simVertices[iev]);
+      batch.fill(events.simTracks[iev],events.simVertices[iev]);
+      nFailures += compareStates("batchPropagation",iev,scalar,batch);
+    }
+    batch.setBatchPropagation(false);
+    return nFailures;
+
+  }
+
+  /// Fill the same SimTrack's with the eager and the lazy propagation, 
+  /// and compare the states found. The lazy tracks are first read at 
+  /// the ECAL (then resumed), at HO, or from the first surface.
+  unsigned lazyPropagation(FSimEvent& eager, FSimEvent& lazy, const Events& events) {
+
+    unsigned nFailures = 0;
+    eager.setLazyPropagation(false);
+    lazy.setLazyPropagation(true);
+    for ( unsigned iev=0; iev<events.simTracks.size(); ++iev ) {
+      eager.fill(events.simTracks[iev],events.simVertices[iev]);
+      lazy.fill(events.simTracks[iev],events.simVertices[iev]);
+      for ( unsigned it=0; it<lazy.nTracks(); ++it ) { 
+	if ( it%3 == 0 ) lazy.track(it).ecalEntrance();
+	else if ( it%3 == 1 ) lazy.track(it).onHO();
+      }
+      nFailures += compareStates("lazyPropagation",iev,eager,lazy);
+    }
+    lazy.setLazyPropagation(false);
+    return nFailures;
+
+  }
+
+
+  /// Compare the shared particle properties with the table and with the
+  /// classification of the filter, and check that an event refuses them
+  /// with another table
+  unsigned particleProperties(const HepPDT::ParticleDataTable& pdt,
+			      const FSimParticleProperties& properties,
+			      const KineParticleFilter& filter,
+			      FSimEvent& simEvent) {
+
+    unsigned nFailures = 0;
+    HepPDT::ParticleDataTable::const_iterator it;
+    for ( it=pdt.begin(); it!=pdt.end(); ++it ) {
+      int id = it->first.pid();
+      int i = properties.index(id);
+      unsigned species = filter.species(id < 0 ? -id : id);
+      if ( i >= 0 && properties.pdgId(i) == id &&
+	   properties.charge(i) == (float)it->second.charge() &&
+	   properties.mass(i) == it->second.mass().value() &&
+	   properties.cTau(i) == it->second.lifetime().value() &&
+	   properties.simulable(i) == ( ( species & KineParticleFilter::SIMULABLE ) != 0 ) &&
+	   properties.forbidden(i) == ( ( species & KineParticleFilter::ALLOWED ) == 0 ) ) continue;
+      std::cerr << "particleProperties: species " << id << " (index " << i 
+		<< ") differs from the table or the filter" << std::endl;
+      ++nFailures;
+    }
+
+    // Properties made from another table are refused
+    HepPDT::ParticleDataTable other("other");
+    BenchmarkTools::minimalTable(other);
+    bool refused = false;
+    try { 
+      simEvent.initializePdt(&other,std::make_shared<const FSimParticleProperties>(pdt,filter));
+    } catch ( const cms::Exception& ) { 
+      refused = true;
+    }
+    if ( !refused ) { 
+      std::cerr << "particleProperties: properties of another table accepted" << std::endl;
+      ++nFailures;
+    }
+    return nFailures;
+
+  }
+}
+
+int main(int argc, char** argv) {
+
+  unsigned nEvents = 20;
+  std::vector<unsigned> multiplicities;
+
+  for ( int i=1; i<argc; ++i ) {
+    std::string arg(argv[i]);
+    if ( arg.size() != 2 || arg[0] != '-' || i+1 == argc ) usage(argv[0]);
+    const char* value = argv[++i];
+    switch ( arg[1] ) {
+    case 'e' : nEvents = std::atoi(value); break;
+    case 's' : multiplicities.push_back(std::atoi(value)); break;
+    default : usage(argv[0]);
+    }
+  }
+  if ( multiplicities.empty() ) {
+    multiplicities.push_back(10);
+    multiplicities.push_back(200);
+    multiplicities.push_back(2000);
+  }
+
+  // The particle data table
+  HepPDT::ParticleDataTable pdt("testEventConsistency");
+  BenchmarkTools::minimalTable(pdt);
+  ParticleTable::instance(&pdt);
+
+  // The fast simulation event
+  TRandom3 smearing(4357);
+  RandomEngine random(&smearing);
+  FSimEvent simEvent(BenchmarkTools::vertexGenerator("Gaussian"),
+		     BenchmarkTools::particleFilter(),&random);
+
+  // The properties of the particles, shared by the events
+  KineParticleFilter filter(BenchmarkTools::particleFilter());
+  std::shared_ptr<const FSimParticleProperties> properties = 
+    std::make_shared<const FSimParticleProperties>(pdt,filter);
+  simEvent.initializePdt(&pdt,properties);
+
+  // The events, of increasing multiplicities, mixed
+  TRandom3 generator(12345);
+  Events events;
+  edm::EventID id(1,1,0);
+  for ( unsigned iev=0; iev<nEvents; ++iev ) {
+    unsigned nParticles = multiplicities[iev%multiplicities.size()];
+    HepMC::GenEvent* genEvent = SyntheticEvents::genEvent(generator,nParticles,iev);
+    events.genEvents.push_back(genEvent);
+    events.genParticles.push_back(reco::GenParticleCollection());
+    SyntheticEvents::genParticles(*genEvent,pdt,events.genParticles.back());
+    simEvent.fill(*genEvent,id);
+    events.simTracks.push_back(edm::SimTrackContainer());
+    events.simVertices.push_back(edm::SimVertexContainer());
+    SyntheticEvents::simTracks(simEvent,events.simTracks.back(),events.simVertices.back());
+  }
+
+  unsigned nFailures = 0;
+  nFailures += steadyState(simEvent,events);
+
+  // The same event, with the batch or the lazy propagation
+  FSimEvent batchEvent(BenchmarkTools::vertexGenerator("Gaussian"),
+		       BenchmarkTools::particleFilter(),&random);
+  batchEvent.initializePdt(&pdt,properties);
+  nFailures += batchPropagation(simEvent,batchEvent,events);
+  nFailures += lazyPropagation(simEvent,batchEvent,events);
+  nFailures += classify(events);
+  nFailures += acceptBatch(events);
+  nFailures += particleProperties(pdt,*properties,filter,batchEvent);
+
+  std::cout << "testEventConsistency: " << nFailures << " failure(s)" << std::endl;
+  return nFailures ? 1 : 0;
+
+}
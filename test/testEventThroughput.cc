@@ -0,0 +1,151 @@
+/** A standalone driver measuring the throughput of FSimEvent::fill (with
+ *  the KineParticleFilter and the primary vertex smearing), outside of
+ *  cmsRun. The events are read from HepMC ASCII files, or generated
+ *  (see SyntheticEvents.h), and kept in memory: only the filling is timed.
+ *
+ *  Usage: testEventThroughput [options] [file.hepmc ...]
+ *    -n passes     number of passes over the events (default 10)
+ *    -s particles  generate synthetic events with this many particles
+ *    -e events     number of synthetic events (default 100)
+ *    -v type       vertex generator: None, Gaussian, Flat or BetaFunc (default Gaussian)
+ *    -p table      HepPDT particle table (default: a minimal built-in table)
+ *
+ *  Reported: events/s, ns per generated particle, the number of heap
+ *  allocations (in total and inside the FSimEvent buffers) per event,
+ *  and the peak resident set size.
+ */
+
+// CMSSW Headers
+#include "DataFormats/Provenance/interface/EventID.h"
+#include "SimGeneral/HepPDTRecord/interface/ParticleDataTable.h"
+
+// FAMOS Headers
+#include "FastSimulation/Event/interface/FSimEvent.h"
+#include "FastSimulation/Particle/interface/ParticleTable.h"
+#include "FastSimulation/Utilities/interface/RandomEngine.h"
+#include "FastSimulation/Event/test/SyntheticEvents.h"
+#include "FastSimulation/Event/test/BenchmarkTools.h"
+
+// HepMC
+#include "HepMC/IO_GenEvent.h"
+
+// ROOT
+#include "TRandom3.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+  void usage(const char* name) {
+    std::cerr << "Usage: " << name
+	      << " [-n passes] [-s particles] [-e events] [-v type] [-p table]"
+	      << " [file.hepmc ...]" << std::endl;
+    std::exit(1);
+  }
+
+}
+
+int main(int argc, char** argv) {
+
+  unsigned nPasses = 10;
+  unsigned nSynthetic = 0;
+  unsigned nEvents = 100;
+  std::string vertexType = "Gaussian";
+  std::string table;
+  std::vector<std::string> files;
+
+  for ( int i=1; i<argc; ++i ) {
+    std::string arg(argv[i]);
+    if ( arg.size() == 2 && arg[0] == '-' ) {
+      if ( i+1 == argc ) usage(argv[0]);
+      const char* value = argv[++i];
+      switch ( arg[1] ) {
+      case 'n' : nPasses = std::atoi(value); break;
+      case 's' : nSynthetic = std::atoi(value); break;
+      case 'e' : nEvents = std::atoi(value); break;
+      case 'v' : vertexType = value; break;
+      case 'p' : table = value; break;
+      default : usage(argv[0]);
+      }
+    } else {
+      files.push_back(arg);
+    }
+  }
+  if ( files.empty() && !nSynthetic ) usage(argv[0]);
+
+  // The particle data table
+  HepPDT::ParticleDataTable pdt("testEventThroughput");
+  if ( table.empty() ) {
+    BenchmarkTools::minimalTable(pdt);
+  } else {
+    std::ifstream input(table.c_str());
+    HepPDT::TableBuilder tb(pdt);
+    if ( !input || !HepPDT::addParticleTable(input,tb,true) ) {
+      std::cerr << "Cannot read the particle table " << table << std::endl;
+      return 1;
+    }
+  }
+  ParticleTable::instance(&pdt);
+
+  // The events, in memory
+  TRandom3 generator(12345);
+  std::vector<HepMC::GenEvent*> events;
+  for ( unsigned ifile=0; ifile<files.size(); ++ifile ) {
+    HepMC::IO_GenEvent input(files[ifile].c_str(),std::ios::in);
+    while ( HepMC::GenEvent* event = input.read_next_event() ) events.push_back(event);
+  }
+  for ( unsigned iev=0; nSynthetic && iev<nEvents; ++iev )
+    events.push_back(SyntheticEvents::genEvent(generator,nSynthetic,iev));
+  if ( events.empty() ) {
+    std::cerr << "No events" << std::endl;
+    return 1;
+  }
+  unsigned long nParticles = 0;
+  for ( unsigned iev=0; iev<events.size(); ++iev ) nParticles += events[iev]->particles_size();
+
+  // The fast simulation event
+  edm::ParameterSet kine = BenchmarkTools::particleFilter();
+  edm::ParameterSet vtx = BenchmarkTools::vertexGenerator(vertexType);
+  TRandom3 smearing(4357);
+  RandomEngine random(&smearing);
+  FSimEvent simEvent(vtx,kine,&random);
+  simEvent.initializePdt(&pdt);
+
+  // A first pass, to grow the buffers to the largest event
+  edm::EventID id(1,1,0);
+  for ( unsigned iev=0; iev<events.size(); ++iev ) simEvent.fill(*events[iev],id);
+
+  // The timed passes
+  unsigned long nTracks = 0;
+  unsigned long bufferAllocations = simEvent.nAllocations();
+  unsigned long heapAllocations = BenchmarkTools::nHeapAllocations();
+  double start = BenchmarkTools::now();
+  for ( unsigned pass=0; pass<nPasses; ++pass ) {
+    for ( unsigned iev=0; iev<events.size(); ++iev ) {
+      simEvent.fill(*events[iev],id);
+      nTracks += simEvent.nTracks();
+    }
+  }
+  double time = BenchmarkTools::now() - start;
+  heapAllocations = BenchmarkTools::nHeapAllocations() - heapAllocations;
+  bufferAllocations = simEvent.nAllocations() - bufferAllocations;
+
+  double nFilled = (double)events.size()*nPasses;
+  std::cout << "Events           : " << events.size() << " x " << nPasses << " passes" << std::endl
+	    << "Particles/event  : " << nParticles/(double)events.size() << std::endl
+	    << "Tracks/event     : " << nTracks/nFilled << std::endl
+	    << "Events/s         : " << nFilled/time << std::endl
+	    << "ns/particle      : " << 1E9*time/(nFilled*nParticles/events.size()) << std::endl
+	    << "Allocations/event: " << heapAllocations/nFilled
+	    << " (buffer growths: " << bufferAllocations << ")" << std::endl
+	    << "Event memory     : " << simEvent.memoryFootprint()/1024. << " kB" << std::endl
+	    << "Peak RSS         : " << BenchmarkTools::peakRSS() << " MB" << std::endl;
+
+  for ( unsigned iev=0; iev<events.size(); ++iev ) delete events[iev];
+  return 0;
+
+}
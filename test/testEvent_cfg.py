@@ -42,7 +42,9 @@ process.test = cms.EDAnalyzer("testEvent",
         # Charged particles with pT < pTMin (GeV/c) are not simulated
         pTMin = cms.double(0.0),
         # Particles with energy smaller than EMin (GeV) are not simulated
-        EMin = cms.double(0.0)
+        EMin = cms.double(0.0),
+        # Report the numbers of particles rejected by each cut at the end
+        printRejectionSummary = cms.untracked.bool(True)
     ),
     GeantInfo = cms.bool(False)
 )